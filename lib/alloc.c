@@ -0,0 +1,243 @@
+#include "limbs.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Every block handed out for a BigNum starts with a header that names its owner,
+  so a buffer can be released or moved to another number without knowing where it came from.
+  Scratch buffers of the limb routines are freed in the same function, they go straight to the hooks.
+*/
+
+#define BLOCK_ALIGN 16
+#define ARENA_DEFAULT_CHUNK ((size_t) 64 * 1024)
+#define POOL_MIN_CLASS 16
+#define POOL_CLASSES 17 //16 bytes .. 1 MiB, larger blocks bypass the free lists
+
+static void *(*alloc_hook)(size_t) = malloc;
+static void *(*realloc_hook)(void *, size_t) = realloc;
+static void (*free_hook)(void *) = free;
+
+static _Thread_local NumCtx thread_ctx = NULL;
+
+enum ctx_kind {
+    CTX_ARENA,
+    CTX_POOL
+};
+
+struct chunk {
+    struct chunk *next;
+    size_t size;
+    size_t used;
+    _Alignas(BLOCK_ALIGN) unsigned char data[];
+};
+
+struct NumCtx {
+    enum ctx_kind kind;
+    struct chunk *chunks; //arena, the newest chunk comes first
+    size_t chunk_size;
+    void *free_lists[POOL_CLASSES]; //pool, freed blocks linked through their first bytes
+};
+
+struct header {
+    NumCtx owner;
+    size_t size; //usable bytes after the header
+};
+typedef struct header header;
+
+_Static_assert(sizeof(header) % BLOCK_ALIGN == 0, "header must keep blocks aligned");
+
+static size_t round_up(size_t size) {
+    return (size + BLOCK_ALIGN - 1) & ~(size_t) (BLOCK_ALIGN - 1);
+}
+
+static header *header_of(void *ptr) {
+    return (header *) ptr - 1;
+}
+
+void SetAllocFunctions(void *(*alloc)(size_t), void *(*realloc_fn)(void *, size_t), void (*free_fn)(void *)) {
+    alloc_hook = alloc != NULL ? alloc : malloc;
+    realloc_hook = realloc_fn != NULL ? realloc_fn : realloc;
+    free_hook = free_fn != NULL ? free_fn : free;
+}
+
+void *scratch_alloc(size_t size) {
+    STAT_ALLOC(size);
+    return alloc_hook(size);
+}
+
+void scratch_free(void *ptr) {
+    if (ptr == NULL) return;
+    STAT_FREE();
+    free_hook(ptr);
+}
+
+void SetThreadCtx(NumCtx ctx) {
+    thread_ctx = ctx;
+}
+
+NumCtx GetThreadCtx() {
+    return thread_ctx;
+}
+
+static NumCtx create_ctx(enum ctx_kind kind) {
+    NumCtx ctx = (NumCtx) alloc_hook(sizeof(struct NumCtx));
+    if (ctx != NULL) {
+        memset(ctx, 0, sizeof(struct NumCtx));
+        ctx->kind = kind;
+    }
+    return ctx;
+}
+
+NumCtx CreateArenaCtx(size_t chunk_size) {
+    NumCtx ctx = create_ctx(CTX_ARENA);
+    if (ctx != NULL) ctx->chunk_size = chunk_size != 0 ? chunk_size : ARENA_DEFAULT_CHUNK;
+    return ctx;
+}
+
+NumCtx CreatePoolCtx() {
+    return create_ctx(CTX_POOL);
+}
+
+void ReleaseCtx(NumCtx ctx) {
+    if (ctx == NULL) return;
+    if (ctx->kind == CTX_ARENA) {
+        //the oldest chunk is kept for the next round of allocations
+        struct chunk *chunk = ctx->chunks;
+        while (chunk != NULL && chunk->next != NULL) {
+            struct chunk *next = chunk->next;
+            free_hook(chunk);
+            chunk = next;
+        }
+        ctx->chunks = chunk;
+        if (chunk != NULL) chunk->used = 0;
+    } else {
+        for (int i = 0; i < POOL_CLASSES; i++) {
+            while (ctx->free_lists[i] != NULL) {
+                void *next = *(void **) ctx->free_lists[i];
+                free_hook(header_of(ctx->free_lists[i]));
+                ctx->free_lists[i] = next;
+            }
+        }
+    }
+}
+
+void FreeCtx(NumCtx ctx) {
+    if (ctx == NULL) return;
+    ReleaseCtx(ctx);
+    if (ctx->kind == CTX_ARENA && ctx->chunks != NULL) free_hook(ctx->chunks);
+    if (thread_ctx == ctx) thread_ctx = NULL;
+    free_hook(ctx);
+}
+
+static void *arena_alloc(NumCtx ctx, size_t size) {
+    size_t need = sizeof(header) + round_up(size);
+    struct chunk *chunk = ctx->chunks;
+    if (chunk == NULL || chunk->size - chunk->used < need) {
+        size_t chunk_size = need > ctx->chunk_size ? need : ctx->chunk_size;
+        chunk = (struct chunk *) alloc_hook(sizeof(struct chunk) + chunk_size);
+        if (chunk == NULL) return NULL;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        chunk->next = ctx->chunks;
+        ctx->chunks = chunk;
+    }
+    header *h = (header *) (chunk->data + chunk->used);
+    chunk->used += need;
+    h->owner = ctx;
+    h->size = size;
+    return h + 1;
+}
+
+//true if the block ends where the free space of the newest chunk begins
+static bool arena_is_last(NumCtx ctx, header *h) {
+    struct chunk *chunk = ctx->chunks;
+    return chunk != NULL && (unsigned char *) (h + 1) + round_up(h->size) == chunk->data + chunk->used;
+}
+
+static int pool_class(size_t size) {
+    int cls = 0;
+    for (size_t class_size = POOL_MIN_CLASS; class_size < size; class_size <<= 1) {
+        cls++;
+    }
+    return cls;
+}
+
+static void *pool_alloc(NumCtx ctx, size_t size) {
+    int cls = pool_class(size);
+    if (cls < POOL_CLASSES) {
+        size = (size_t) POOL_MIN_CLASS << cls;
+        if (ctx->free_lists[cls] != NULL) {
+            void *ptr = ctx->free_lists[cls];
+            ctx->free_lists[cls] = *(void **) ptr;
+            return ptr;
+        }
+    }
+    header *h = (header *) alloc_hook(sizeof(header) + size);
+    if (h == NULL) return NULL;
+    h->owner = ctx;
+    h->size = size;
+    return h + 1;
+}
+
+void *num_alloc(NumCtx ctx, size_t size) {
+    STAT_ALLOC(size);
+    if (ctx == NULL) {
+        header *h = (header *) alloc_hook(sizeof(header) + size);
+        if (h == NULL) return NULL;
+        h->owner = NULL;
+        h->size = size;
+        return h + 1;
+    }
+    return ctx->kind == CTX_ARENA ? arena_alloc(ctx, size) : pool_alloc(ctx, size);
+}
+
+void num_free(void *ptr) {
+    if (ptr == NULL) return;
+    STAT_FREE();
+    header *h = header_of(ptr);
+    NumCtx owner = h->owner;
+    if (owner == NULL) {
+        free_hook(h);
+    } else if (owner->kind == CTX_ARENA) {
+        //only the newest block can be given back before the whole arena is released
+        if (arena_is_last(owner, h)) owner->chunks->used -= sizeof(header) + round_up(h->size);
+    } else {
+        int cls = pool_class(h->size);
+        if (cls < POOL_CLASSES) {
+            *(void **) ptr = owner->free_lists[cls];
+            owner->free_lists[cls] = ptr;
+        } else {
+            free_hook(h);
+        }
+    }
+}
+
+//the block moves to ctx unless it can grow where it is
+void *num_realloc(NumCtx ctx, void *ptr, size_t size) {
+    if (ptr == NULL) return num_alloc(ctx, size);
+    header *h = header_of(ptr);
+    if (size <= h->size) return ptr;
+    STAT_REALLOC(size);
+    NumCtx owner = h->owner;
+    if (owner == NULL && ctx == NULL) {
+        h = (header *) realloc_hook(h, sizeof(header) + size);
+        if (h == NULL) return NULL;
+        h->size = size;
+        return h + 1;
+    }
+    if (owner != NULL && owner == ctx && owner->kind == CTX_ARENA && arena_is_last(owner, h)) {
+        struct chunk *chunk = owner->chunks;
+        size_t extra = round_up(size) - round_up(h->size);
+        if (chunk->size - chunk->used >= extra) {
+            chunk->used += extra;
+            h->size = size;
+            return ptr;
+        }
+    }
+    void *res = num_alloc(ctx, size);
+    if (res == NULL) return NULL;
+    memcpy(res, ptr, h->size);
+    num_free(ptr);
+    return res;
+}
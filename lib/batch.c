@@ -0,0 +1,210 @@
+#include "number.h"
+#include "limbs.h"
+#include <string.h>
+
+/*
+  Without a pool a batch is a loop over the operations. With one, it first reserves the storage of every result
+  on the calling thread, since contexts are not synchronized, and the arithmetic then finds its results
+  large enough and allocates nothing, so it may run anywhere.
+  A product that overwrites one of its operands needs a fresh buffer and is computed right away instead.
+*/
+
+//operands of a struct-of-arrays batch whose carries are kept at once, the unit the pool splits
+#define SOA_BLOCK 64
+
+struct batch {
+    int8_t (*op)(BigNum a, BigNum b, BigNum res); //NULL for comparisons
+    const BigNum *a, *b;
+    BigNum *res;
+    int8_t *order; //results of comparisons
+    bool reserved; //products that overwrite an operand are done
+};
+
+static bool overwrites_operand(const struct batch *batch, size_t i) {
+    return batch->res[i] == batch->a[i] || batch->res[i] == batch->b[i];
+}
+
+static int8_t batch_range(void *ctx, size_t begin, size_t end) {
+    struct batch *batch = (struct batch *) ctx;
+    const BigNum *a = batch->a, *b = batch->b;
+    if (batch->op == NULL) {
+        for (size_t i = begin; i < end; i++) {
+            if (a[i] == NULL || b[i] == NULL) return ERROR;
+            batch->order[i] = Compare(a[i], b[i]);
+        }
+        return SUCCESS;
+    }
+    bool skip_aliased = batch->reserved && batch->op == Mult;
+    for (size_t i = begin; i < end; i++) {
+        if (skip_aliased && overwrites_operand(batch, i)) continue;
+        if (batch->op(a[i], b[i], batch->res[i]) == ERROR) return ERROR;
+    }
+    return SUCCESS;
+}
+
+//storage of the result of entry i
+static int8_t batch_reserve(struct batch *batch, size_t i) {
+    BigNum a = batch->a[i], b = batch->b[i], res = batch->res[i];
+    if (a == NULL || b == NULL || res == NULL) return ERROR;
+    if (batch->op != Mult) {
+        //the sum keeps the value of an operand it overwrites
+        return ReserveNum(res, (a->size_ > b->size_ ? a->size_ : b->size_) + 1);
+    }
+    if (overwrites_operand(batch, i)) return Mult(a, b, res);
+    if (res->capacity_ >= a->size_ + b->size_) return SUCCESS;
+    res->size_ = 0;
+    return ReserveNum(res, a->size_ + b->size_);
+}
+
+static int8_t run_batch(struct batch *batch, size_t n) {
+    if (batch->a == NULL || batch->b == NULL || (batch->res == NULL && batch->order == NULL)) return ERROR;
+    if (parallel_threads() == 1) return batch_range(batch, 0, n);
+    size_t limbs = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (batch->a[i] == NULL || batch->b[i] == NULL) return ERROR;
+        limbs += batch->a[i]->size_ + batch->b[i]->size_;
+    }
+    if (!parallel_worth(limbs)) return batch_range(batch, 0, n);
+    if (batch->op != NULL) {
+        for (size_t i = 0; i < n; i++) {
+            if (batch_reserve(batch, i) == ERROR) return ERROR;
+        }
+        batch->reserved = true;
+    }
+    return parallel_for(n, 1, batch_range, batch);
+}
+
+int8_t AddBatch(const BigNum *a, const BigNum *b, BigNum *res, size_t n) {
+    struct batch batch = {Add, a, b, res, NULL, false};
+    return run_batch(&batch, n);
+}
+
+int8_t SubBatch(const BigNum *a, const BigNum *b, BigNum *res, size_t n) {
+    struct batch batch = {Sub, a, b, res, NULL, false};
+    return run_batch(&batch, n);
+}
+
+int8_t MultBatch(const BigNum *a, const BigNum *b, BigNum *res, size_t n) {
+    struct batch batch = {Mult, a, b, res, NULL, false};
+    return run_batch(&batch, n);
+}
+
+int8_t CompareBatch(const BigNum *a, const BigNum *b, int8_t *res, size_t n) {
+    struct batch batch = {NULL, a, b, NULL, res, false};
+    return run_batch(&batch, n);
+}
+
+/*
+  Struct-of-arrays batches. The loops run across the operands of a block, which do not depend on each other,
+  so compilers turn them into vector code. Baseline x86-64 has no 64-bit vector compares to find the carries,
+  so every loop is also compiled for AVX2 and picked with the kernel set.
+  Products are left out: there are no 64-bit vector multiplications, and gathering operands for the scalar
+  basecase is slower than running MultBatch or CtMult on them one by one.
+*/
+struct soa {
+    limb_t *r, *carry;
+    const limb_t *a, *b;
+    int8_t *order;
+    size_t width, count;
+    void (*lanes)(const struct soa *soa, size_t first, size_t lanes);
+};
+
+//the loops of one block, compiled once per instruction set by SOA_VARIANTS
+static inline __attribute__((always_inline)) void add_lanes(const struct soa *soa, size_t first, size_t lanes) {
+    size_t count = soa->count;
+    limb_t c[SOA_BLOCK] = {0};
+    for (size_t j = 0; j < soa->width; j++) {
+        const limb_t *a = soa->a + j * count + first, *b = soa->b + j * count + first;
+        limb_t *r = soa->r + j * count + first;
+        for (size_t k = 0; k < lanes; k++) {
+            limb_t s = a[k] + b[k], t = s + c[k];
+            c[k] = (s < a[k]) | (t < s);
+            r[k] = t;
+        }
+    }
+    if (soa->carry != NULL) memcpy(soa->carry + first, c, sizeof(limb_t) * lanes);
+}
+
+static inline __attribute__((always_inline)) void sub_lanes(const struct soa *soa, size_t first, size_t lanes) {
+    size_t count = soa->count;
+    limb_t c[SOA_BLOCK] = {0};
+    for (size_t j = 0; j < soa->width; j++) {
+        const limb_t *a = soa->a + j * count + first, *b = soa->b + j * count + first;
+        limb_t *r = soa->r + j * count + first;
+        for (size_t k = 0; k < lanes; k++) {
+            limb_t d = a[k] - b[k];
+            limb_t borrow = (a[k] < b[k]) | (d < c[k]);
+            r[k] = d - c[k];
+            c[k] = borrow;
+        }
+    }
+    if (soa->carry != NULL) memcpy(soa->carry + first, c, sizeof(limb_t) * lanes);
+}
+
+//the first differing limb from the top decides, later ones leave a decided lane alone
+static inline __attribute__((always_inline)) void compare_lanes(const struct soa *soa, size_t first, size_t lanes) {
+    size_t count = soa->count;
+    int8_t *order = soa->order + first;
+    memset(order, 0, lanes);
+    for (size_t j = soa->width; j-- > 0;) {
+        const limb_t *a = soa->a + j * count + first, *b = soa->b + j * count + first;
+        for (size_t k = 0; k < lanes; k++) {
+            int8_t d = (int8_t) ((a[k] > b[k]) - (a[k] < b[k]));
+            order[k] = order[k] != 0 ? order[k] : d;
+        }
+    }
+}
+
+#define SOA_GENERIC(name) \
+    static void name##_generic(const struct soa *soa, size_t first, size_t lanes) { name(soa, first, lanes); }
+
+#if defined(__x86_64__)
+#define SOA_VARIANTS(name) \
+    SOA_GENERIC(name) \
+    __attribute__((target("avx2"))) \
+    static void name##_avx2(const struct soa *soa, size_t first, size_t lanes) { name(soa, first, lanes); }
+#define SOA_PICK(name) (limb_kernel_set >= KERNELS_AVX2 ? name##_avx2 : name##_generic)
+#else
+#define SOA_VARIANTS(name) SOA_GENERIC(name)
+#define SOA_PICK(name) name##_generic
+#endif
+
+SOA_VARIANTS(add_lanes)
+
+SOA_VARIANTS(sub_lanes)
+
+SOA_VARIANTS(compare_lanes)
+
+static int8_t soa_blocks(void *ctx, size_t begin, size_t end) {
+    struct soa *soa = (struct soa *) ctx;
+    for (size_t block = begin; block < end; block++) {
+        size_t first = block * SOA_BLOCK;
+        soa->lanes(soa, first, soa->count - first < SOA_BLOCK ? soa->count - first : SOA_BLOCK);
+    }
+    return SUCCESS;
+}
+
+//runs the blocks of count operands, on the pool for large batches
+static void soa_run(struct soa *soa) {
+    size_t blocks = (soa->count + SOA_BLOCK - 1) / SOA_BLOCK;
+    if (parallel_worth(soa->width * soa->count)) {
+        parallel_for(blocks, 1, soa_blocks, soa);
+    } else {
+        soa_blocks(soa, 0, blocks);
+    }
+}
+
+void AddSoA(limb_t *r, limb_t *carry, const limb_t *a, const limb_t *b, size_t width, size_t count) {
+    struct soa soa = {r, carry, a, b, NULL, width, count, SOA_PICK(add_lanes)};
+    soa_run(&soa);
+}
+
+void SubSoA(limb_t *r, limb_t *borrow, const limb_t *a, const limb_t *b, size_t width, size_t count) {
+    struct soa soa = {r, borrow, a, b, NULL, width, count, SOA_PICK(sub_lanes)};
+    soa_run(&soa);
+}
+
+void CompareSoA(int8_t *res, const limb_t *a, const limb_t *b, size_t width, size_t count) {
+    struct soa soa = {NULL, NULL, a, b, res, width, count, SOA_PICK(compare_lanes)};
+    soa_run(&soa);
+}
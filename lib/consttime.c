@@ -0,0 +1,142 @@
+#include "number.h"
+#include "limbs.h"
+#include <string.h>
+
+/*
+  Every routine here runs the same instructions on the same addresses for all values of a given width.
+  Only fixed-length kernels are used: add_n, sub_n, mul_1 and addmul_1 have no early exits,
+  unlike add_1 and sub_1 or anything that trims leading zero limbs. Decisions become all-ones or
+  all-zero masks, and a table entry is fetched by reading every entry.
+*/
+
+#define CT_WINDOW 4
+
+//all ones if x == y, else zero
+static limb_t ct_eq_mask(limb_t x, limb_t y) {
+    limb_t d = x ^ y;
+    return ((d | -d) >> (LIMB_BITS - 1)) - 1;
+}
+
+//1 if x < y, else 0
+static limb_t ct_lt(limb_t x, limb_t y) {
+    return ((~x & y) | (~(x ^ y) & (x - y))) >> (LIMB_BITS - 1);
+}
+
+//r = cond ? a : b, cond is 0 or 1; r may coincide with a or b
+static void ct_select(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t cond) {
+    limb_t mask = -cond;
+    for (size_t i = 0; i < n; i++) {
+        r[i] = (a[i] & mask) | (b[i] & ~mask);
+    }
+}
+
+int8_t CtFromNum(limb_t *r, size_t n, BigNum num) {
+    if (r == NULL || num == NULL || num->sign_ == -1 || num->size_ > n) return ERROR;
+    memcpy(r, num->limbs_, sizeof(limb_t) * num->size_);
+    memset(r + num->size_, 0, sizeof(limb_t) * (n - num->size_));
+    return SUCCESS;
+}
+
+int8_t CtToNum(BigNum num, const limb_t *a, size_t n) {
+    if (num == NULL || a == NULL || n == 0) return ERROR;
+    num->size_ = 0;
+    if (ReserveNum(num, n) == ERROR) return ERROR;
+    memcpy(num->limbs_, a, sizeof(limb_t) * n);
+    num->size_ = limbs_normalized_size(num->limbs_, n);
+    num->sign_ = 1;
+    return SUCCESS;
+}
+
+limb_t CtAdd(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    return limbs_add_n(r, a, b, n);
+}
+
+limb_t CtSub(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    return limbs_sub_n(r, a, b, n);
+}
+
+void CtMult(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    if (a == b) {
+        limbs_sqr_basecase(r, a, n);
+    } else {
+        limbs_mul_basecase(r, a, n, b, n);
+    }
+}
+
+int8_t CtCompare(const limb_t *a, const limb_t *b, size_t n) {
+    limb_t greater = 0, less = 0;
+    for (size_t i = n; i-- > 0;) {
+        limb_t open = 1 ^ (greater | less);
+        greater |= ct_lt(b[i], a[i]) & open;
+        less |= ct_lt(a[i], b[i]) & open;
+    }
+    return (int8_t) ((int) greater - (int) less);
+}
+
+void CtSwap(limb_t *a, limb_t *b, size_t n, limb_t cond) {
+    limb_t mask = -cond;
+    for (size_t i = 0; i < n; i++) {
+        limb_t t = (a[i] ^ b[i]) & mask;
+        a[i] ^= t;
+        b[i] ^= t;
+    }
+}
+
+//r = a * b * B^-n mod m, the inputs are below B^n and one of them below m; t has 2n limbs
+static void ct_mont_mul(limb_t *r, const limb_t *a, const limb_t *b, const struct ModCtx *ctx, limb_t *t) {
+    size_t n = ctx->n;
+    CtMult(t, a, b, n);
+    for (size_t i = 0; i < n; i++) {
+        t[i] = limbs_addmul_1(t + i, ctx->m, n, t[i] * ctx->minv);
+    }
+    //u = t / B^n < 2m, u - m is kept when u did not fit into n limbs or did not borrow
+    limb_t carry = limbs_add_n(r, t + n, t, n);
+    limb_t borrow = limbs_sub_n(t, r, ctx->m, n);
+    ct_select(r, t, r, n, carry | (borrow ^ 1));
+}
+
+//r = table[index] out of count entries of n limbs, every entry is read
+static void ct_lookup(limb_t *r, const limb_t *table, size_t count, size_t n, limb_t index) {
+    memset(r, 0, sizeof(limb_t) * n);
+    for (size_t e = 0; e < count; e++) {
+        limb_t mask = ct_eq_mask(e, index);
+        for (size_t i = 0; i < n; i++) {
+            r[i] |= table[e * n + i] & mask;
+        }
+    }
+}
+
+//fixed windows over all en * LIMB_BITS exponent bits, a zero window still multiplies by the table entry for 1
+int8_t CtPowMod(limb_t *r, const limb_t *base, const limb_t *exp, size_t en, ModCtx ctx) {
+    if (r == NULL || base == NULL || exp == NULL || ctx == NULL || !ctx->montgomery) return ERROR;
+    size_t n = ctx->n, count = (size_t) 1 << CT_WINDOW;
+    limb_t *scratch = (limb_t *) scratch_alloc(sizeof(limb_t) * ((count + 2) * n + 2 * n));
+    if (scratch == NULL) return ERROR;
+    limb_t *table = scratch, *acc = scratch + count * n, *x = acc + n, *t = x + n;
+
+    //table[e] = base^e * B^n mod m, table[0] comes from 1 * B^2n
+    memset(x, 0, sizeof(limb_t) * n);
+    x[0] = 1;
+    ct_mont_mul(table, x, ctx->r2, ctx, t);
+    ct_mont_mul(table + n, base, ctx->r2, ctx, t);
+    for (size_t e = 2; e < count; e++) {
+        ct_mont_mul(table + e * n, table + (e - 1) * n, table + n, ctx, t);
+    }
+
+    memcpy(acc, table, sizeof(limb_t) * n);
+    for (size_t bit = en * LIMB_BITS; bit > 0;) {
+        bit -= CT_WINDOW;
+        for (int s = 0; s < CT_WINDOW; s++) {
+            ct_mont_mul(acc, acc, acc, ctx, t);
+        }
+        ct_lookup(x, table, count, n, (exp[bit / LIMB_BITS] >> (bit % LIMB_BITS)) & (count - 1));
+        ct_mont_mul(acc, acc, x, ctx, t);
+    }
+
+    //leaving Montgomery form is a multiplication by 1
+    memset(x, 0, sizeof(limb_t) * n);
+    x[0] = 1;
+    ct_mont_mul(r, acc, x, ctx, t);
+    scratch_free(scratch);
+    return SUCCESS;
+}
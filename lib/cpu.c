@@ -0,0 +1,60 @@
+#include "limbs.h"
+
+//starts portable so the kernels work even before the constructor below has run
+struct limb_kernels limb_kernels = {limbs_add_n_generic, limbs_sub_n_generic,
+                                    limbs_mul_1_generic, limbs_addmul_1_generic, limbs_submul_1_generic};
+enum kernel_set limb_kernel_set = KERNELS_GENERIC;
+
+static const struct limb_kernels kernel_sets[KERNEL_SETS_COUNT] = {
+        [KERNELS_GENERIC] = {limbs_add_n_generic, limbs_sub_n_generic,
+                             limbs_mul_1_generic, limbs_addmul_1_generic, limbs_submul_1_generic},
+#if defined(__x86_64__)
+        [KERNELS_X86_64] = {limbs_add_n_x86_64, limbs_sub_n_x86_64,
+                            limbs_mul_1_generic, limbs_addmul_1_generic, limbs_submul_1_generic},
+        [KERNELS_MULX] = {limbs_add_n_x86_64, limbs_sub_n_x86_64,
+                          limbs_mul_1_mulx, limbs_addmul_1_mulx, limbs_submul_1_mulx},
+        [KERNELS_AVX2] = {limbs_add_n_avx2, limbs_sub_n_avx2,
+                          limbs_mul_1_mulx, limbs_addmul_1_mulx, limbs_submul_1_mulx},
+        [KERNELS_AVX512] = {limbs_add_n_avx512, limbs_sub_n_avx512,
+                            limbs_mul_1_mulx, limbs_addmul_1_mulx, limbs_submul_1_mulx},
+#endif
+};
+
+static bool cpu_supports(enum kernel_set set) {
+    switch (set) {
+        case KERNELS_GENERIC:
+            return true;
+#if defined(__x86_64__)
+        case KERNELS_X86_64:
+            return true;
+        case KERNELS_MULX:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx");
+        case KERNELS_AVX2:
+            return cpu_supports(KERNELS_MULX) && __builtin_cpu_supports("avx2");
+        case KERNELS_AVX512:
+            return cpu_supports(KERNELS_MULX) && __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+enum kernel_set limbs_best_kernels() {
+    for (int set = KERNEL_SETS_COUNT - 1; set > KERNELS_GENERIC; set--) {
+        if (cpu_supports((enum kernel_set) set)) return (enum kernel_set) set;
+    }
+    return KERNELS_GENERIC;
+}
+
+int8_t limbs_use_kernels(enum kernel_set set) {
+    if (set < 0 || set >= KERNEL_SETS_COUNT || !cpu_supports(set)) return ERROR;
+    limb_kernels = kernel_sets[set];
+    limb_kernel_set = set;
+    return SUCCESS;
+}
+
+__attribute__((constructor))
+static void select_kernels() {
+    limbs_use_kernels(limbs_best_kernels());
+}
@@ -0,0 +1,402 @@
+#include "limbs.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Division of limb arrays by a normalized divisor (top bit of the top limb set).
+  Quotients of u by d with dn limbs are produced a block at a time, every routine leaves the remainder
+  in the low dn limbs of u and returns the top quotient limb (0 or 1) that did not fit into q.
+*/
+
+//Knuth's algorithm D, q gets un - dn limbs, dn >= 2
+static limb_t div_basecase(limb_t *q, limb_t *u, size_t un, const limb_t *d, size_t dn) {
+    limb_t d1 = d[dn - 1], d0 = d[dn - 2];
+    limb_t qh = limbs_cmp(u + un - dn, dn, d, dn) != -1;
+    if (qh) limbs_sub(u + un - dn, u + un - dn, dn, d, dn);
+
+    for (size_t j = un - dn; j-- > 0;) {
+        limb_t n2 = u[j + dn], n1 = u[j + dn - 1], n0 = u[j + dn - 2];
+        limb_t qhat;
+        if (n2 >= d1) {
+            qhat = ~(limb_t) 0;
+        } else {
+            dlimb_t num = ((dlimb_t) n2 << LIMB_BITS) | n1;
+            qhat = (limb_t) (num / d1);
+            dlimb_t rhat = num % d1;
+            while ((dlimb_t) qhat * d0 > ((rhat << LIMB_BITS) | n0)) {
+                qhat--;
+                rhat += d1;
+                if (rhat >> LIMB_BITS) break;
+            }
+        }
+        limb_t borrow = limbs_submul_1(u + j, d, dn, qhat);
+        limb_t top = n2 - borrow;
+        bool negative = n2 < borrow;
+        while (negative) {
+            qhat--;
+            limb_t carry = limbs_add(u + j, u + j, dn, d, dn);
+            limb_t sum = top + carry;
+            if (sum < top) negative = false;
+            top = sum;
+        }
+        u[j + dn] = top;
+        q[j] = qhat;
+    }
+    return qh;
+}
+
+//Burnikel-Ziegler: 2n limbs of u by n limbs of d, both halves of the quotient are recursive 3n/2n steps
+static limb_t div_2n_by_n(limb_t *q, limb_t *u, const limb_t *d, size_t n, int8_t *code) {
+    if (n < threshold_values[THRESHOLD_DIV_BZ]) return div_basecase(q, u, 2 * n, d, n);
+    size_t lo = n / 2, hi = n - lo;
+    limb_t *tmp = (limb_t *) scratch_alloc(sizeof(limb_t) * n);
+    if (tmp == NULL) {
+        *code = ERROR;
+        return 0;
+    }
+
+    //upper half of the quotient from the top 2 * hi limbs and the top hi limbs of d, then fix with the rest of d
+    limb_t qh = div_2n_by_n(q + lo, u + 2 * lo, d + lo, hi, code);
+    if (*code == ERROR || limbs_mul(tmp, q + lo, hi, d, lo) == ERROR) {
+        *code = ERROR;
+        scratch_free(tmp);
+        return 0;
+    }
+    limb_t cy = limbs_sub(u + lo, u + lo, n, tmp, n);
+    if (qh != 0) cy += limbs_sub(u + n, u + n, lo, d, lo);
+    while (cy != 0) {
+        qh -= limbs_sub_1(q + lo, q + lo, hi, 1);
+        cy -= limbs_add(u + lo, u + lo, n, d, n);
+    }
+
+    limb_t ql = div_2n_by_n(q, u + hi, d + hi, lo, code);
+    if (*code == ERROR || limbs_mul(tmp, d, hi, q, lo) == ERROR) {
+        *code = ERROR;
+        scratch_free(tmp);
+        return 0;
+    }
+    cy = limbs_sub(u, u, n, tmp, n);
+    if (ql != 0) cy += limbs_sub(u + lo, u + lo, hi, d, hi);
+    while (cy != 0) {
+        limbs_sub_1(q, q, lo, 1);
+        cy -= limbs_add(u, u, n, d, n);
+    }
+    scratch_free(tmp);
+    return qh;
+}
+
+/*
+  Quotient shorter than the divisor: divide the top 2 * qn + 1 limbs of u by the top qn + 1 limbs of d,
+  which overestimates the quotient by a small amount, then correct it against the full divisor.
+  u[un - dn..un) < d is required.
+*/
+static void div_short_quotient(limb_t *q, limb_t *u, size_t un, const limb_t *d, size_t dn, int8_t *code) {
+    size_t qn = un - dn;
+    size_t skip = dn - qn - 1;
+    limb_t *tmp = (limb_t *) scratch_alloc(sizeof(limb_t) * (2 * qn + 2 + un));
+    if (tmp == NULL) {
+        *code = ERROR;
+        return;
+    }
+    limb_t *top = tmp, *prod = tmp + 2 * qn + 2;
+
+    if (limbs_cmp(u + un - qn - 1, qn + 1, d + skip, qn + 1) == 0) {
+        memset(q, 0xff, sizeof(limb_t) * qn);
+    } else {
+        //one zero limb on top turns this into a 2n / n division with n = qn + 1
+        memcpy(top, u + skip, sizeof(limb_t) * (2 * qn + 1));
+        top[2 * qn + 1] = 0;
+        limb_t *q_top = prod;
+        div_2n_by_n(q_top, top, d + skip, qn + 1, code);
+        memcpy(q, q_top, sizeof(limb_t) * qn);
+        if (q_top[qn] != 0) memset(q, 0xff, sizeof(limb_t) * qn);
+    }
+    if (*code == ERROR || limbs_mul(prod, d, dn, q, qn) == ERROR) {
+        *code = ERROR;
+        scratch_free(tmp);
+        return;
+    }
+    while (limbs_cmp(prod, un, u, un) == 1) {
+        limbs_sub_1(q, q, qn, 1);
+        limbs_sub(prod, prod, un, d, dn);
+    }
+    limbs_sub(u, u, un, prod, un);
+    scratch_free(tmp);
+}
+
+//q gets un - dn limbs, u[un - dn..un) < d is required
+static limb_t div_qr(limb_t *q, limb_t *u, size_t un, const limb_t *d, size_t dn, int8_t *code) {
+    size_t qn = un - dn;
+    size_t threshold = threshold_values[THRESHOLD_DIV_BZ];
+    if (dn < threshold || qn < threshold) return div_basecase(q, u, un, d, dn);
+    if (qn < dn) {
+        div_short_quotient(q, u, un, d, dn, code);
+        return 0;
+    }
+    size_t first = qn % dn;
+    if (first != 0) {
+        div_qr(q + qn - first, u + qn - first, dn + first, d, dn, code);
+    }
+    for (size_t off = qn - first; off > 0 && *code != ERROR;) {
+        off -= dn;
+        div_2n_by_n(q + off, u + off, d, dn, code);
+    }
+    return 0;
+}
+
+#ifdef NUM_STATS
+static enum StatTier division_tier(size_t an, size_t dn) {
+    size_t threshold = threshold_values[THRESHOLD_DIV_BZ];
+    return dn < threshold || an + 1 - dn < threshold ? STAT_DIV_BASECASE : STAT_DIV_BZ;
+}
+#endif
+
+//a and d normalized into u and dd, then the quotient; tmp has an + 1 + dn limbs and dn >= 2
+static int8_t divmod_normalized(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *d, size_t dn,
+                                limb_t *tmp, bool basecase) {
+    limb_t *u = tmp, *dd = tmp + an + 1;
+    unsigned shift = __builtin_clzll(d[dn - 1]);
+    if (shift != 0) {
+        limbs_lshift(dd, d, dn, shift);
+        u[an] = limbs_lshift(u, a, an, shift);
+    } else {
+        memcpy(dd, d, sizeof(limb_t) * dn);
+        memcpy(u, a, sizeof(limb_t) * an);
+        u[an] = 0;
+    }
+
+    //the extra top limb of u keeps its top dn limbs below dd
+    int8_t code = SUCCESS;
+    if (basecase) {
+        div_basecase(q, u, an + 1, dd, dn);
+    } else {
+        div_qr(q, u, an + 1, dd, dn, &code);
+    }
+    if (shift != 0) {
+        limbs_rshift(r, u, dn, shift);
+    } else {
+        memcpy(r, u, sizeof(limb_t) * dn);
+    }
+    return code;
+}
+
+//q = a / d with an - dn + 1 limbs, r = a % d with dn limbs; an >= dn and the top limb of d is not zero
+int8_t limbs_divmod(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *d, size_t dn) {
+    if (dn == 1) {
+        r[0] = STAT_TIMED(STAT_DIV_1, limbs_divmod_1(q, a, an, d[0]));
+        return SUCCESS;
+    }
+    limb_t *tmp = (limb_t *) scratch_alloc(sizeof(limb_t) * (an + 1 + dn));
+    if (tmp == NULL) return ERROR;
+    int8_t code = STAT_TIMED(division_tier(an, dn), divmod_normalized(q, r, a, an, d, dn, tmp, false));
+    scratch_free(tmp);
+    return code;
+}
+
+//limbs_divmod by Knuth's algorithm alone in tmp of an + 1 + dn limbs, allocates nothing; q and r may overlap a or d
+void limbs_divmod_basecase(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *d, size_t dn, limb_t *tmp) {
+    if (dn == 1) {
+        limb_t divisor = d[0];
+        r[0] = limbs_divmod_1(q, a, an, divisor);
+        return;
+    }
+    divmod_normalized(q, r, a, an, d, dn, tmp, true);
+}
+
+/*
+  Invariant division after Möller and Granlund: with the reciprocal v of a normalized divisor,
+  a quotient limb costs a multiplication and a few corrections instead of a hardware division.
+*/
+
+//v = (B^2 - 1) / d - B for the top bit of d set
+static limb_t reciprocal_2by1(limb_t d) {
+    return (limb_t) ((((dlimb_t) ~d) << LIMB_BITS | ~(limb_t) 0) / d);
+}
+
+//v = (B^3 - 1) / (d1, d0) - B for the top bit of d1 set
+static limb_t reciprocal_3by2(limb_t d1, limb_t d0) {
+    limb_t v = reciprocal_2by1(d1);
+    limb_t p = d1 * v + d0;
+    if (p < d0) {
+        v--;
+        if (p >= d1) {
+            v--;
+            p -= d1;
+        }
+        p -= d1;
+    }
+    dlimb_t t = (dlimb_t) v * d0;
+    limb_t t1 = (limb_t) (t >> LIMB_BITS), t0 = (limb_t) t;
+    p += t1;
+    if (p < t1) {
+        v--;
+        if (p > d1 || (p == d1 && t0 >= d0)) v--;
+    }
+    return v;
+}
+
+//(u1, u0) / d with u1 < d, stores the remainder in r
+static inline limb_t div_2by1(limb_t *r, limb_t u1, limb_t u0, limb_t d, limb_t v) {
+    dlimb_t qq = (dlimb_t) u1 * v + ((dlimb_t) u1 << LIMB_BITS | u0);
+    limb_t q = (limb_t) (qq >> LIMB_BITS) + 1, q0 = (limb_t) qq;
+    limb_t rem = u0 - q * d;
+    if (rem > q0) {
+        q--;
+        rem += d;
+    }
+    if (rem >= d) {
+        q++;
+        rem -= d;
+    }
+    *r = rem;
+    return q;
+}
+
+//(n2, n1, n0) / (d1, d0) with (n2, n1) < (d1, d0), stores the two remainder limbs in r
+static inline limb_t div_3by2(dlimb_t *r, limb_t n2, limb_t n1, limb_t n0, limb_t d1, limb_t d0, limb_t v) {
+    dlimb_t d = (dlimb_t) d1 << LIMB_BITS | d0;
+    dlimb_t qq = (dlimb_t) n2 * v + ((dlimb_t) n2 << LIMB_BITS | n1);
+    limb_t q = (limb_t) (qq >> LIMB_BITS), q0 = (limb_t) qq;
+    limb_t r1 = n1 - d1 * q;
+    dlimb_t rem = ((dlimb_t) r1 << LIMB_BITS | n0) - d - (dlimb_t) d0 * q;
+    q++;
+    if ((limb_t) (rem >> LIMB_BITS) >= q0) {
+        q--;
+        rem += d;
+    }
+    if (rem >= d) {
+        q++;
+        rem -= d;
+    }
+    *r = rem;
+    return q;
+}
+
+//a / d for a divisor d = norm >> shift of one limb, q gets n limbs and may be a
+static limb_t divmod_1_preinv(limb_t *q, const limb_t *a, size_t n, limb_t norm, unsigned shift, limb_t v) {
+    limb_t rem = shift != 0 ? a[n - 1] >> (LIMB_BITS - shift) : 0;
+    for (size_t i = n; i-- > 0;) {
+        limb_t u0 = a[i] << shift;
+        if (shift != 0 && i != 0) u0 |= a[i - 1] >> (LIMB_BITS - shift);
+        q[i] = div_2by1(&rem, rem, u0, norm, v);
+    }
+    return rem >> shift;
+}
+
+//limbs of d below the top two up to which div_preinv subtracts inline instead of through the kernel table
+#define SHORT_SUBMUL 4
+
+static inline limb_t submul_short(limb_t *r, const limb_t *a, size_t n, limb_t m) {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        dlimb_t p = (dlimb_t) a[i] * m + borrow;
+        limb_t lo = (limb_t) p;
+        borrow = (limb_t) (p >> LIMB_BITS) + (r[i] < lo);
+        r[i] -= lo;
+    }
+    return borrow;
+}
+
+//div_basecase with the reciprocal v of the top two limbs of d
+static limb_t div_preinv(limb_t *q, limb_t *u, size_t un, const limb_t *d, size_t dn, limb_t v) {
+    limb_t d1 = d[dn - 1], d0 = d[dn - 2];
+    limb_t qh = limbs_cmp(u + un - dn, dn, d, dn) != -1;
+    if (qh) limbs_sub(u + un - dn, u + un - dn, dn, d, dn);
+
+    //the top limb of the partial remainder stays in n1, the next one below is in u
+    limb_t n1 = u[un - 1];
+    for (size_t j = un - dn; j-- > 0;) {
+        limb_t qhat;
+        if (n1 == d1 && u[j + dn - 1] == d0) {
+            qhat = ~(limb_t) 0;
+            limbs_submul_1(u + j, d, dn, qhat);
+            n1 = u[j + dn - 1];
+        } else {
+            dlimb_t rem;
+            qhat = div_3by2(&rem, n1, u[j + dn - 1], u[j + dn - 2], d1, d0, v);
+            limb_t borrow = dn - 2 > SHORT_SUBMUL ? limbs_submul_1(u + j, d, dn - 2, qhat)
+                                                  : submul_short(u + j, d, dn - 2, qhat);
+            bool negative = rem < borrow;
+            rem -= borrow;
+            n1 = (limb_t) (rem >> LIMB_BITS);
+            u[j + dn - 2] = (limb_t) rem;
+            if (negative) {
+                n1 += d1 + limbs_add_n(u + j, u + j, d, dn - 1);
+                qhat--;
+            }
+        }
+        q[j] = qhat;
+    }
+    u[dn - 1] = n1;
+    return qh;
+}
+
+Divisor CreateDivisor(BigNum d) {
+    if (d == NULL || d->size_ == 0 || (d->size_ == 1 && d->limbs_[0] == 0)) return NULL;
+    size_t n = d->size_;
+    Divisor divisor = (Divisor) scratch_alloc(sizeof(struct Divisor));
+    limb_t *limbs = (limb_t *) scratch_alloc(sizeof(limb_t) * 2 * n);
+    if (divisor == NULL || limbs == NULL) {
+        scratch_free(divisor);
+        scratch_free(limbs);
+        return NULL;
+    }
+    divisor->n = n;
+    divisor->sign = d->sign_;
+    divisor->d = limbs;
+    divisor->norm = limbs + n;
+    memcpy(divisor->d, d->limbs_, sizeof(limb_t) * n);
+    divisor->shift = __builtin_clzll(d->limbs_[n - 1]);
+    if (divisor->shift != 0) {
+        limbs_lshift(divisor->norm, divisor->d, n, divisor->shift);
+    } else {
+        memcpy(divisor->norm, divisor->d, sizeof(limb_t) * n);
+    }
+    limb_t *norm = divisor->norm;
+    divisor->inv = n == 1 ? reciprocal_2by1(norm[0]) : reciprocal_3by2(norm[n - 1], norm[n - 2]);
+    return divisor;
+}
+
+void FreeDivisor(Divisor divisor) {
+    if (divisor == NULL) return;
+    scratch_free(divisor->d);
+    scratch_free(divisor);
+}
+
+//limbs_divmod by a precomputed divisor, q and r may be a
+int8_t limbs_divmod_by(limb_t *q, limb_t *r, const limb_t *a, size_t an, const struct Divisor *d) {
+    size_t dn = d->n;
+    if (dn == 1) {
+        r[0] = STAT_TIMED(STAT_DIV_1, divmod_1_preinv(q, a, an, d->norm[0], d->shift, d->inv));
+        return SUCCESS;
+    }
+    limb_t *u = (limb_t *) scratch_alloc(sizeof(limb_t) * (an + 1));
+    if (u == NULL) return ERROR;
+    if (d->shift != 0) {
+        u[an] = limbs_lshift(u, a, an, d->shift);
+    } else {
+        memcpy(u, a, sizeof(limb_t) * an);
+        u[an] = 0;
+    }
+
+    //Burnikel-Ziegler from the same sizes on as in limbs_divmod
+    int8_t code = SUCCESS;
+    size_t threshold = threshold_values[THRESHOLD_DIV_BZ];
+    if (dn < threshold || an + 1 - dn < threshold) {
+        STAT_TIER_BEGIN(STAT_DIV_BASECASE);
+        div_preinv(q, u, an + 1, d->norm, dn, d->inv);
+        STAT_TIER_END(STAT_DIV_BASECASE);
+    } else {
+        STAT_TIER_BEGIN(STAT_DIV_BZ);
+        div_qr(q, u, an + 1, d->norm, dn, &code);
+        STAT_TIER_END(STAT_DIV_BZ);
+    }
+    if (d->shift != 0) {
+        limbs_rshift(r, u, dn, d->shift);
+    } else {
+        memcpy(r, u, sizeof(limb_t) * dn);
+    }
+    scratch_free(u);
+    return code;
+}
@@ -0,0 +1,238 @@
+#include "number.h"
+#include "limbs.h"
+#include <string.h>
+
+/*
+  Nodes only refer to nodes built before them, so one backward sweep from the root finds the nodes it uses
+  and how often, and one forward sweep bounds their sizes: a sum has a limb more than its larger operand,
+  a product the limbs of both. Every node then needs at most its bound plus a limb of temporary storage,
+  their total is the block the evaluation runs in.
+  A sum collects the terms of the sums below it that nothing else uses into one accumulator, and a product
+  among them that nothing else uses is accumulated by limbs_acc_addmul, without a temporary of its own
+  when it is small. Every other node is evaluated into its own part of the block once and read from there.
+*/
+
+#define EXPR_MIN_NODES 8
+
+enum expr_op {
+    EXPR_NUM,
+    EXPR_ADD,
+    EXPR_SUB,
+    EXPR_MULT
+};
+
+//a signed magnitude in the form of a BigNum
+struct value {
+    const limb_t *limbs;
+    size_t n;
+    int sign;
+};
+
+struct expr_node {
+    enum expr_op op;
+    ExprNode lhs, rhs;
+    BigNum num;
+    //state of the current evaluation
+    size_t uses;
+    size_t bound;
+    bool done;
+    struct value value;
+};
+
+struct Expr {
+    struct expr_node *nodes;
+    size_t count, capacity;
+    limb_t *block; //temporaries of evaluations
+    size_t block_size, used;
+};
+
+Expr CreateExpr() {
+    Expr expr = (Expr) scratch_alloc(sizeof(struct Expr));
+    if (expr != NULL) memset(expr, 0, sizeof(struct Expr));
+    return expr;
+}
+
+void FreeExpr(Expr expr) {
+    if (expr == NULL) return;
+    scratch_free(expr->nodes);
+    scratch_free(expr->block);
+    scratch_free(expr);
+}
+
+static ExprNode push_node(Expr expr, enum expr_op op, ExprNode lhs, ExprNode rhs, BigNum num) {
+    if (expr->count == expr->capacity) {
+        size_t capacity = expr->capacity != 0 ? 2 * expr->capacity : EXPR_MIN_NODES;
+        struct expr_node *nodes = (struct expr_node *) scratch_alloc(sizeof(struct expr_node) * capacity);
+        if (nodes == NULL) return EXPR_INVALID;
+        if (expr->count != 0) memcpy(nodes, expr->nodes, sizeof(struct expr_node) * expr->count);
+        scratch_free(expr->nodes);
+        expr->nodes = nodes;
+        expr->capacity = capacity;
+    }
+    struct expr_node *node = &expr->nodes[expr->count];
+    memset(node, 0, sizeof(struct expr_node));
+    node->op = op;
+    node->lhs = lhs;
+    node->rhs = rhs;
+    node->num = num;
+    return expr->count++;
+}
+
+ExprNode ExprNum(Expr expr, BigNum num) {
+    if (expr == NULL || num == NULL) return EXPR_INVALID;
+    return push_node(expr, EXPR_NUM, EXPR_INVALID, EXPR_INVALID, num);
+}
+
+//EXPR_INVALID is never below count, so invalid operands are caught here
+static ExprNode binary(Expr expr, enum expr_op op, ExprNode lhs, ExprNode rhs) {
+    if (expr == NULL || lhs >= expr->count || rhs >= expr->count) return EXPR_INVALID;
+    return push_node(expr, op, lhs, rhs, NULL);
+}
+
+ExprNode ExprAdd(Expr expr, ExprNode lhs, ExprNode rhs) {
+    return binary(expr, EXPR_ADD, lhs, rhs);
+}
+
+ExprNode ExprSub(Expr expr, ExprNode lhs, ExprNode rhs) {
+    return binary(expr, EXPR_SUB, lhs, rhs);
+}
+
+ExprNode ExprMult(Expr expr, ExprNode lhs, ExprNode rhs) {
+    return binary(expr, EXPR_MULT, lhs, rhs);
+}
+
+static limb_t *take(Expr expr, size_t limbs) {
+    limb_t *r = expr->block + expr->used;
+    expr->used += limbs;
+    return r;
+}
+
+static int8_t eval_into(Expr expr, ExprNode i, limb_t *r, size_t *rn, int *r_sign);
+
+static int8_t eval(Expr expr, ExprNode i, struct value *v) {
+    struct expr_node *node = &expr->nodes[i];
+    if (node->op == EXPR_NUM) {
+        *v = (struct value) {node->num->limbs_, node->num->size_, node->num->sign_};
+        return SUCCESS;
+    }
+    if (!node->done) {
+        limb_t *r = take(expr, node->bound + 1);
+        size_t n;
+        int sign;
+        if (eval_into(expr, i, r, &n, &sign) == ERROR) return ERROR;
+        node->value = (struct value) {r, n, sign};
+        node->done = true;
+    }
+    *v = node->value;
+    return SUCCESS;
+}
+
+//acc += sign * node i, the terms of sums and products used only here go into acc directly
+static int8_t accumulate(Expr expr, ExprNode i, int sign, limb_t *r, size_t *rn, int *r_sign) {
+    struct expr_node *node = &expr->nodes[i];
+    if ((node->op == EXPR_ADD || node->op == EXPR_SUB) && node->uses == 1) {
+        if (accumulate(expr, node->lhs, sign, r, rn, r_sign) == ERROR) return ERROR;
+        return accumulate(expr, node->rhs, node->op == EXPR_SUB ? -sign : sign, r, rn, r_sign);
+    }
+    struct value a, b;
+    if (node->op == EXPR_MULT && node->uses == 1) {
+        if (eval(expr, node->lhs, &a) == ERROR || eval(expr, node->rhs, &b) == ERROR) return ERROR;
+        return limbs_acc_addmul(r, rn, r_sign, a.limbs, a.n, b.limbs, b.n, sign * a.sign * b.sign,
+                                take(expr, node->bound + 1));
+    }
+    if (eval(expr, i, &a) == ERROR) return ERROR;
+    limbs_acc_add(r, rn, r_sign, a.limbs, a.n, sign * a.sign);
+    return SUCCESS;
+}
+
+//node i into r of its bound plus a limb
+static int8_t eval_into(Expr expr, ExprNode i, limb_t *r, size_t *rn, int *r_sign) {
+    struct expr_node *node = &expr->nodes[i];
+    if (node->op == EXPR_MULT) {
+        struct value a, b;
+        if (eval(expr, node->lhs, &a) == ERROR || eval(expr, node->rhs, &b) == ERROR) return ERROR;
+        if (limbs_mul(r, a.limbs, a.n, b.limbs, b.n) == ERROR) return ERROR;
+        *rn = limbs_normalized_size(r, a.n + b.n);
+        *r_sign = *rn == 1 && r[0] == 0 ? 1 : a.sign * b.sign;
+        return SUCCESS;
+    }
+    r[0] = 0;
+    *rn = 1;
+    *r_sign = 1;
+    //the sum itself is not shared with anyone in here
+    if (accumulate(expr, node->lhs, 1, r, rn, r_sign) == ERROR) return ERROR;
+    return accumulate(expr, node->rhs, node->op == EXPR_SUB ? -1 : 1, r, rn, r_sign);
+}
+
+//marks what root uses and bounds it, the limbs of temporaries it needs, or 0 for an uninitialized number
+static size_t prepare(Expr expr, ExprNode root, BigNum res, bool *res_used) {
+    struct expr_node *nodes = expr->nodes;
+    for (size_t i = 0; i <= root; i++) {
+        nodes[i].uses = 0;
+        nodes[i].done = false;
+    }
+    nodes[root].uses = 1;
+    for (size_t i = root + 1; i-- > 0;) {
+        if (nodes[i].uses != 0 && nodes[i].op != EXPR_NUM) {
+            nodes[nodes[i].lhs].uses++;
+            nodes[nodes[i].rhs].uses++;
+        }
+    }
+    size_t total = 1;
+    *res_used = false;
+    for (size_t i = 0; i <= root; i++) {
+        struct expr_node *node = &nodes[i];
+        if (node->uses == 0) continue;
+        size_t lhs = node->op == EXPR_NUM ? 0 : nodes[node->lhs].bound;
+        size_t rhs = node->op == EXPR_NUM ? 0 : nodes[node->rhs].bound;
+        if (node->op == EXPR_NUM) {
+            if (node->num->size_ == 0) return 0;
+            node->bound = node->num->size_;
+            *res_used |= node->num == res;
+        } else if (node->op == EXPR_MULT) {
+            node->bound = lhs + rhs;
+        } else {
+            node->bound = (lhs > rhs ? lhs : rhs) + 1;
+        }
+        if (node->op != EXPR_NUM) total += node->bound + 1;
+    }
+    return total;
+}
+
+int8_t EvalExpr(Expr expr, ExprNode root, BigNum res) {
+    if (expr == NULL || res == NULL || root >= expr->count) return ERROR;
+    bool res_used;
+    size_t total = prepare(expr, root, res, &res_used);
+    if (total == 0) return ERROR;
+    if (total > expr->block_size) {
+        limb_t *block = (limb_t *) scratch_alloc(sizeof(limb_t) * total);
+        if (block == NULL) return ERROR;
+        scratch_free(expr->block);
+        expr->block = block;
+        expr->block_size = total;
+    }
+    expr->used = 0;
+    struct expr_node *node = &expr->nodes[root];
+    if (node->op == EXPR_NUM) return CopyNum(node->num, res);
+
+    //the result goes straight into res unless the expression still reads it
+    limb_t *r;
+    if (res_used) {
+        r = take(expr, node->bound + 1);
+    } else {
+        res->size_ = 0;
+        if (ReserveNum(res, node->bound + 1) == ERROR) return ERROR;
+        r = res->limbs_;
+    }
+    size_t n;
+    int sign;
+    if (eval_into(expr, root, r, &n, &sign) == ERROR) return ERROR;
+    if (res_used) {
+        res->size_ = 0;
+        if (ReserveNum(res, n) == ERROR) return ERROR;
+        memcpy(res->limbs_, r, sizeof(limb_t) * n);
+    }
+    res->size_ = n;
+    res->sign_ = sign;
+    return SUCCESS;
+}
@@ -0,0 +1,26 @@
+#include "fixed.h"
+#include "limbs.h"
+#include <string.h>
+
+int8_t FixedDivMod(limb_t *q, limb_t *r, const limb_t *a, const limb_t *d, size_t n, limb_t *work) {
+    size_t an = limbs_normalized_size(a, n), dn = limbs_normalized_size(d, n);
+    if (dn == 1 && d[0] == 0) return ERROR;
+    if (an < dn) {
+        if (r != NULL) memmove(r, a, sizeof(limb_t) * n);
+        if (q != NULL) memset(q, 0, sizeof(limb_t) * n);
+        return SUCCESS;
+    }
+
+    //both results land in work first, q and r may be a or d
+    limb_t *quot = work + 2 * n + 1, *rem = quot + an - dn + 1;
+    limbs_divmod_basecase(quot, rem, a, an, d, dn, work);
+    if (q != NULL) {
+        memcpy(q, quot, sizeof(limb_t) * (an - dn + 1));
+        memset(q + an - dn + 1, 0, sizeof(limb_t) * (n - an + dn - 1));
+    }
+    if (r != NULL) {
+        memcpy(r, rem, sizeof(limb_t) * dn);
+        memset(r + dn, 0, sizeof(limb_t) * (n - dn));
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,166 @@
+#ifndef ARBITARYPRECISIONARITHMETICS_FIXED_H
+#define ARBITARYPRECISIONARITHMETICS_FIXED_H
+
+#include "number.h"
+
+/*
+  Fixed-width unsigned integers, U256 to U4096, that live wherever they are declared and never allocate.
+  FIXED_WIDTH generates the type and the operations of one width; their limb count is a constant,
+  so the compiler unrolls the loops below for it. Further widths, multiples of 64 bits, may be generated likewise.
+  Add, Sub, Mult and Shl wrap around and return true when the exact result did not fit,
+  FromNum returns ERROR for negative numbers and those that do not fit, ToNum converts back.
+  Results may coincide with operands.
+*/
+
+static inline bool fixed_add(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    limb_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned __int128 s = (unsigned __int128) a[i] + b[i] + carry;
+        r[i] = (limb_t) s;
+        carry = (limb_t) (s >> LIMB_BITS);
+    }
+    return carry != 0;
+}
+
+static inline bool fixed_sub(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned __int128 d = (unsigned __int128) a[i] - b[i] - borrow;
+        r[i] = (limb_t) d;
+        borrow = (limb_t) (d >> LIMB_BITS) & 1;
+    }
+    return borrow != 0;
+}
+
+static inline int8_t fixed_compare(const limb_t *a, const limb_t *b, size_t n) {
+    for (size_t i = n; i-- > 0;) {
+        if (a[i] != b[i]) return a[i] > b[i] ? 1 : -1;
+    }
+    return 0;
+}
+
+//index of the top nonzero limb, 0 for zero
+static inline size_t fixed_top(const limb_t *a, size_t n) {
+    size_t top = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] != 0) top = i;
+    }
+    return top;
+}
+
+/*
+  The low n limbs of a * b. With tops ta and tb, a * b >= B^(ta + tb), so that overflows if ta + tb >= n,
+  and otherwise every partial product lands below limb n and only the carries out of the rows are lost.
+  t has n limbs, so that r may coincide with a or b.
+*/
+static inline bool fixed_mult(limb_t *r, const limb_t *a, const limb_t *b, size_t n, limb_t *t) {
+    bool overflow = fixed_top(a, n) + fixed_top(b, n) >= n;
+    for (size_t i = 0; i < n; i++) t[i] = 0;
+    for (size_t i = 0; i < n; i++) {
+        limb_t carry = 0;
+        for (size_t j = 0; i + j < n; j++) {
+            unsigned __int128 p = (unsigned __int128) a[j] * b[i] + t[i + j] + carry;
+            t[i + j] = (limb_t) p;
+            carry = (limb_t) (p >> LIMB_BITS);
+        }
+        overflow |= carry != 0;
+    }
+    for (size_t i = 0; i < n; i++) r[i] = t[i];
+    return overflow;
+}
+
+//true if a set bit was shifted out
+static inline bool fixed_shl(limb_t *r, const limb_t *a, size_t n, unsigned shift) {
+    size_t limbs = shift / LIMB_BITS;
+    unsigned bits = shift % LIMB_BITS;
+    bool overflow = false;
+    for (size_t i = 0; i < n; i++) {
+        if (i + limbs >= n && a[i] != 0) overflow = true;
+    }
+    if (limbs < n && bits != 0 && a[n - limbs - 1] >> (LIMB_BITS - bits) != 0) overflow = true;
+    for (size_t i = n; i-- > 0;) {
+        limb_t hi = i >= limbs ? a[i - limbs] : 0;
+        limb_t lo = i >= limbs + 1 ? a[i - limbs - 1] : 0;
+        r[i] = bits == 0 ? hi : hi << bits | lo >> (LIMB_BITS - bits);
+    }
+    return overflow;
+}
+
+static inline void fixed_shr(limb_t *r, const limb_t *a, size_t n, unsigned shift) {
+    size_t limbs = shift / LIMB_BITS;
+    unsigned bits = shift % LIMB_BITS;
+    for (size_t i = 0; i < n; i++) {
+        limb_t lo = i + limbs < n ? a[i + limbs] : 0;
+        limb_t hi = i + limbs + 1 < n ? a[i + limbs + 1] : 0;
+        r[i] = bits == 0 ? lo : lo >> bits | hi << (LIMB_BITS - bits);
+    }
+}
+
+//q = a / d, r = a % d in work of 3n + 2 limbs, either result may be NULL; ERROR for d = 0
+int8_t FixedDivMod(limb_t *q, limb_t *r, const limb_t *a, const limb_t *d, size_t n, limb_t *work);
+
+#define FIXED_WIDTH(bits) \
+    typedef struct U##bits { \
+        limb_t limbs[(bits) / LIMB_BITS]; \
+    } U##bits; \
+    \
+    static inline void U##bits##SetU64(U##bits *r, uint64_t x) { \
+        for (size_t i = 0; i < (bits) / LIMB_BITS; i++) r->limbs[i] = i == 0 ? x : 0; \
+    } \
+    \
+    static inline int8_t U##bits##FromNum(U##bits *r, BigNum num) { \
+        return CtFromNum(r->limbs, (bits) / LIMB_BITS, num); \
+    } \
+    \
+    static inline int8_t U##bits##ToNum(BigNum num, const U##bits *a) { \
+        return CtToNum(num, a->limbs, (bits) / LIMB_BITS); \
+    } \
+    \
+    static inline bool U##bits##IsZero(const U##bits *a) { \
+        limb_t any = 0; \
+        for (size_t i = 0; i < (bits) / LIMB_BITS; i++) any |= a->limbs[i]; \
+        return any == 0; \
+    } \
+    \
+    static inline bool U##bits##Add(U##bits *r, const U##bits *a, const U##bits *b) { \
+        return fixed_add(r->limbs, a->limbs, b->limbs, (bits) / LIMB_BITS); \
+    } \
+    \
+    static inline bool U##bits##Sub(U##bits *r, const U##bits *a, const U##bits *b) { \
+        return fixed_sub(r->limbs, a->limbs, b->limbs, (bits) / LIMB_BITS); \
+    } \
+    \
+    static inline bool U##bits##Mult(U##bits *r, const U##bits *a, const U##bits *b) { \
+        limb_t t[(bits) / LIMB_BITS]; \
+        return fixed_mult(r->limbs, a->limbs, b->limbs, (bits) / LIMB_BITS, t); \
+    } \
+    \
+    static inline int8_t U##bits##DivMod(U##bits *q, U##bits *r, const U##bits *a, const U##bits *d) { \
+        limb_t work[3 * (bits) / LIMB_BITS + 2]; \
+        return FixedDivMod(q == NULL ? NULL : q->limbs, r == NULL ? NULL : r->limbs, a->limbs, d->limbs, \
+                           (bits) / LIMB_BITS, work); \
+    } \
+    \
+    static inline int8_t U##bits##Compare(const U##bits *a, const U##bits *b) { \
+        return fixed_compare(a->limbs, b->limbs, (bits) / LIMB_BITS); \
+    } \
+    \
+    static inline bool U##bits##Shl(U##bits *r, const U##bits *a, unsigned shift) { \
+        return fixed_shl(r->limbs, a->limbs, (bits) / LIMB_BITS, shift); \
+    } \
+    \
+    static inline void U##bits##Shr(U##bits *r, const U##bits *a, unsigned shift) { \
+        fixed_shr(r->limbs, a->limbs, (bits) / LIMB_BITS, shift); \
+    }
+
+FIXED_WIDTH(256)
+
+FIXED_WIDTH(512)
+
+FIXED_WIDTH(1024)
+
+FIXED_WIDTH(2048)
+
+FIXED_WIDTH(4096)
+
+#endif //ARBITARYPRECISIONARITHMETICS_FIXED_H
@@ -0,0 +1,565 @@
+#include "number.h"
+#include "limbs.h"
+#include "stats.h"
+#include <string.h>
+
+/*
+  Euclid's algorithm runs in batches of quotient steps. A batch is a continuant matrix [s0 t0; s1 t1]
+  of nonnegative entries with a parity k, it maps the remainders (x, y) to
+  x' = (-1)^k (s0 x - t0 y),  y' = (-1)^(k+1) (s1 x - t1 y)
+  and the cofactors of x and y, whose signs alternate in the same way, to s0 u_x + t0 u_y and s1 u_x + t1 u_y,
+  with additions only. A single quotient q is the batch [0 1; 1 q] of parity 1.
+
+  Lehmer's step finds a batch with single-limb entries from the leading 128 bits of x and y.
+  The half-GCD finds one whose entries have about half the limbs of x from the leading half of x and y,
+  by recursing twice on quarters, which makes the whole algorithm subquadratic.
+  A batch found from leading parts is applied to the full numbers only while its remainders stay well
+  above its entries, then the error of the truncation cannot change the signs above.
+*/
+
+//remainders first, then the cofactors of the second and of the first input
+#define REMAINDERS 0
+#define Y_COFACTORS 1
+#define X_COFACTORS 2
+
+//two values going through the same batches, the next batch is written to nx and ny
+struct pair {
+    limb_t *x, *y, *nx, *ny;
+    size_t xn, yn, nxn, nyn;
+};
+
+/*
+  x = (-1)^parity (u_x * x0 - v_x * y0) and y = (-1)^(parity+1) (u_y * x0 - v_y * y0),
+  u in the X_COFACTORS pair, v in Y_COFACTORS; so the cofactors are the entries of the batch
+  that leads from (x0, y0) to (x, y).
+*/
+struct gcd_state {
+    struct pair p[3];
+    int pairs; //tracked pairs, remainders only, up to the cofactors of y0, or all of them
+    int parity;
+    size_t steps;
+    size_t cap; //limbs of every buffer
+    limb_t *storage;
+};
+
+static bool is_zero_limbs(const limb_t *a, size_t n) {
+    return n == 1 && a[0] == 0;
+}
+
+static int8_t init_state(struct gcd_state *st, const limb_t *x, size_t xn, const limb_t *y, size_t yn, int pairs) {
+    st->pairs = pairs;
+    st->parity = 0;
+    st->steps = 0;
+    //cofactors stay below x0, the products in Lehmer's step take one limb more than x
+    st->cap = xn + 3;
+    st->storage = (limb_t *) scratch_alloc(sizeof(limb_t) * 4 * st->cap * pairs);
+    if (st->storage == NULL) return ERROR;
+    for (int i = 0; i < pairs; i++) {
+        struct pair *p = &st->p[i];
+        p->x = st->storage + 4 * i * st->cap;
+        p->y = p->x + st->cap;
+        p->nx = p->y + st->cap;
+        p->ny = p->nx + st->cap;
+        p->xn = p->yn = 1;
+    }
+    memcpy(st->p[REMAINDERS].x, x, sizeof(limb_t) * xn);
+    memcpy(st->p[REMAINDERS].y, y, sizeof(limb_t) * yn);
+    st->p[REMAINDERS].xn = xn;
+    st->p[REMAINDERS].yn = yn;
+    if (pairs > Y_COFACTORS) {
+        st->p[Y_COFACTORS].x[0] = 0;
+        st->p[Y_COFACTORS].y[0] = 1;
+    }
+    if (pairs > X_COFACTORS) {
+        st->p[X_COFACTORS].x[0] = 1;
+        st->p[X_COFACTORS].y[0] = 0;
+    }
+    return SUCCESS;
+}
+
+static void swap_pair(struct pair *p) {
+    limb_t *t = p->x;
+    p->x = p->y;
+    p->y = t;
+    size_t n = p->xn;
+    p->xn = p->yn;
+    p->yn = n;
+}
+
+//makes the next values current, a remainder pair out of order is swapped, which is a step with quotient 0
+static void commit(struct gcd_state *st, int k) {
+    for (int i = 0; i < st->pairs; i++) {
+        struct pair *p = &st->p[i];
+        limb_t *t = p->x;
+        p->x = p->nx;
+        p->nx = t;
+        t = p->y;
+        p->y = p->ny;
+        p->ny = t;
+        p->xn = p->nxn;
+        p->yn = p->nyn;
+    }
+    st->parity ^= k & 1;
+    st->steps++;
+    struct pair *r = &st->p[REMAINDERS];
+    if (limbs_cmp(r->x, r->xn, r->y, r->yn) == -1) {
+        for (int i = 0; i < st->pairs; i++) {
+            swap_pair(&st->p[i]);
+        }
+        st->parity ^= 1;
+    }
+}
+
+//the next remainders are two limbs longer than the cofactors that belong to them
+static bool dominates(const struct gcd_state *st) {
+    const struct pair *r = &st->p[REMAINDERS], *v = &st->p[Y_COFACTORS], *u = &st->p[X_COFACTORS];
+    size_t ex = u->nxn > v->nxn ? u->nxn : v->nxn;
+    size_t ey = u->nyn > v->nyn ? u->nyn : v->nyn;
+    return r->nxn >= ex + 2 && r->nyn >= ey + 2;
+}
+
+static void negate(limb_t *a, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        a[i] = ~a[i];
+    }
+    limbs_add_1(a, a, n, 1);
+}
+
+//r = |p x - q y| with xn >= yn, r has xn + 1 limbs; sets negative when p x < q y
+static size_t combine_diff(limb_t *r, const limb_t *x, size_t xn, limb_t p, const limb_t *y, size_t yn, limb_t q,
+                           bool *negative) {
+    r[xn] = limbs_mul_1(r, x, xn, p, 0);
+    limb_t borrow = limbs_submul_1(r, y, yn, q);
+    borrow = limbs_sub_1(r + yn, r + yn, xn + 1 - yn, borrow);
+    *negative = borrow != 0;
+    if (*negative) negate(r, xn + 1);
+    return limbs_normalized_size(r, xn + 1);
+}
+
+//r = p x + q y, r has max(xn, yn) + 2 limbs
+static size_t combine_sum(limb_t *r, const limb_t *x, size_t xn, limb_t p, const limb_t *y, size_t yn, limb_t q) {
+    size_t n = xn > yn ? xn : yn;
+    r[xn] = limbs_mul_1(r, x, xn, p, 0);
+    memset(r + xn + 1, 0, sizeof(limb_t) * (n + 1 - xn));
+    limb_t carry = limbs_addmul_1(r, y, yn, q);
+    limbs_add_1(r + yn, r + yn, n + 2 - yn, carry);
+    return limbs_normalized_size(r, n + 2);
+}
+
+//writes the next values of a batch with single-limb entries e, false if a remainder would change its sign
+static bool apply_1(struct gcd_state *st, const limb_t e[4], int k) {
+    struct pair *r = &st->p[REMAINDERS];
+    bool negative_x, negative_y;
+    r->nxn = combine_diff(r->nx, r->x, r->xn, e[0], r->y, r->yn, e[1], &negative_x);
+    r->nyn = combine_diff(r->ny, r->x, r->xn, e[2], r->y, r->yn, e[3], &negative_y);
+    if (negative_x != (k & 1) || (negative_y != !(k & 1) && !is_zero_limbs(r->ny, r->nyn))) return false;
+    for (int i = 1; i < st->pairs; i++) {
+        struct pair *c = &st->p[i];
+        c->nxn = combine_sum(c->nx, c->x, c->xn, e[0], c->y, c->yn, e[1]);
+        c->nyn = combine_sum(c->ny, c->x, c->xn, e[2], c->y, c->yn, e[3]);
+    }
+    return true;
+}
+
+/*
+  Lehmer's step: Euclid on the leading 128 bits x^ and y^ of x and y, cut at the same position.
+  The true remainders differ from the approximate ones, scaled back, by less than the largest cofactor,
+  which stays below 2^63, so the remainders are kept only while they reach 2^64.
+*/
+static bool lehmer_batch(const struct gcd_state *st, limb_t e[4], int *k) {
+    const struct pair *r = &st->p[REMAINDERS];
+    size_t n = r->xn;
+    if (n < 2 || r->yn + 1 < n) return false;
+    unsigned shift = __builtin_clzll(r->x[n - 1]);
+    limb_t words[2][3];
+    for (int i = 0; i < 3; i++) {
+        words[0][i] = n >= 3 - (size_t) i ? r->x[n - 3 + i] : 0;
+        words[1][i] = n >= 3 - (size_t) i && n - 3 + i < r->yn ? r->y[n - 3 + i] : 0;
+    }
+    dlimb_t top[2];
+    for (int j = 0; j < 2; j++) {
+        limb_t hi = words[j][2], mid = words[j][1], lo = words[j][0];
+        if (shift != 0) {
+            hi = hi << shift | mid >> (LIMB_BITS - shift);
+            mid = mid << shift | lo >> (LIMB_BITS - shift);
+        }
+        top[j] = (dlimb_t) hi << LIMB_BITS | mid;
+    }
+
+    const dlimb_t limit = (dlimb_t) 1 << LIMB_BITS, cofactor_limit = (limb_t) 1 << (LIMB_BITS - 1);
+    dlimb_t x = top[0], y = top[1];
+    limb_t s0 = 1, t0 = 0, s1 = 0, t1 = 1;
+    int steps = 0;
+    while (y >= limit) {
+        //most quotients are small, and a 128-bit division is slow
+        dlimb_t q = 1, z = x - y;
+        while (z >= y && q < 4) {
+            z -= y;
+            q++;
+        }
+        if (z >= y) {
+            q = x / y;
+            z = x - q * y;
+        }
+        if (z < limit || q >= cofactor_limit) break;
+        dlimb_t s2 = s0 + q * s1, t2 = t0 + q * t1;
+        if (s2 >= cofactor_limit || t2 >= cofactor_limit) break;
+        x = y;
+        y = z;
+        s0 = s1;
+        t0 = t1;
+        s1 = (limb_t) s2;
+        t1 = (limb_t) t2;
+        steps++;
+    }
+    e[0] = s0;
+    e[1] = t0;
+    e[2] = s1;
+    e[3] = t1;
+    *k = steps;
+    return steps != 0;
+}
+
+//writes the next values of a single quotient step, y must not be zero
+static int8_t division_step(struct gcd_state *st) {
+    struct pair *r = &st->p[REMAINDERS];
+    size_t qn = r->xn - r->yn + 1;
+    limb_t *q = (limb_t *) scratch_alloc(sizeof(limb_t) * (qn + st->cap));
+    if (q == NULL) return ERROR;
+    limb_t *product = q + qn;
+    if (limbs_divmod(q, r->ny, r->x, r->xn, r->y, r->yn) == ERROR) {
+        scratch_free(q);
+        return ERROR;
+    }
+    qn = limbs_normalized_size(q, qn);
+    r->nyn = limbs_normalized_size(r->ny, r->yn);
+    memcpy(r->nx, r->y, sizeof(limb_t) * r->yn);
+    r->nxn = r->yn;
+
+    int8_t code = SUCCESS;
+    for (int i = 1; i < st->pairs && code == SUCCESS; i++) {
+        struct pair *c = &st->p[i];
+        memcpy(c->nx, c->y, sizeof(limb_t) * c->yn);
+        c->nxn = c->yn;
+        //cofactors stay below x0, so the product fits whenever the sum does
+        size_t pn = qn + c->yn;
+        if (is_zero_limbs(c->y, c->yn)) {
+            product[0] = 0;
+            pn = 1;
+        } else if (limbs_mul(product, q, qn, c->y, c->yn) == ERROR) {
+            code = ERROR;
+            break;
+        }
+        pn = limbs_normalized_size(product, pn);
+        const limb_t *a = product, *b = c->x;
+        size_t an = pn, bn = c->xn;
+        if (an < bn) {
+            a = c->x;
+            b = product;
+            an = c->xn;
+            bn = pn;
+        }
+        c->ny[an] = limbs_add(c->ny, a, an, b, bn);
+        c->nyn = limbs_normalized_size(c->ny, an + 1);
+    }
+    scratch_free(q);
+    return code;
+}
+
+//tmp = |s x - t y| with dn limbs, sets negative when s x < t y; tmp has sn + xn + tn + yn limbs
+static int8_t products_diff(const limb_t *s, size_t sn, const limb_t *x, size_t xn, const limb_t *t, size_t tn,
+                            const limb_t *y, size_t yn, limb_t *tmp, size_t *dn, bool *negative) {
+    limb_t *sx = tmp, *ty = tmp + sn + xn;
+    if (limbs_mul(sx, s, sn, x, xn) == ERROR || limbs_mul(ty, t, tn, y, yn) == ERROR) return ERROR;
+    size_t sxn = limbs_normalized_size(sx, sn + xn), tyn = limbs_normalized_size(ty, tn + yn);
+    *negative = limbs_cmp(sx, sxn, ty, tyn) == -1;
+    if (*negative) {
+        //ty only partly overlaps the start of tmp, so the difference is formed in place and moved down
+        limbs_sub(ty, ty, tyn, sx, sxn);
+        memmove(sx, ty, sizeof(limb_t) * tyn);
+        sxn = tyn;
+    } else {
+        limbs_sub(sx, sx, sxn, ty, tyn);
+    }
+    *dn = limbs_normalized_size(sx, sxn);
+    return SUCCESS;
+}
+
+//r = top * B^p + d or - d, false if that is not positive or takes more than cap limbs
+static bool shifted_sum(limb_t *r, size_t *rn, size_t cap, const limb_t *top, size_t topn, size_t p, const limb_t *d,
+                        size_t dn, bool subtract) {
+    size_t n = topn + p;
+    if (n + 1 > cap || dn + 1 > cap) return false;
+    memset(r, 0, sizeof(limb_t) * p);
+    memcpy(r + p, top, sizeof(limb_t) * topn);
+    if (subtract) {
+        if (limbs_cmp(r, n, d, dn) != 1) return false;
+        limbs_sub(r, r, n, d, dn);
+    } else if (dn <= n) {
+        r[n] = limbs_add(r, r, n, d, dn);
+        n++;
+    } else {
+        r[dn] = limbs_add(r, d, dn, r, n);
+        n = dn + 1;
+    }
+    *rn = limbs_normalized_size(r, n);
+    return true;
+}
+
+//r = s x + t y, ERROR when it takes more than cap limbs; tmp has sn + xn + tn + yn limbs
+static int8_t products_sum(limb_t *r, size_t *rn, size_t cap, const limb_t *s, size_t sn, const limb_t *x, size_t xn,
+                           const limb_t *t, size_t tn, const limb_t *y, size_t yn, limb_t *tmp) {
+    limb_t *sx = tmp, *ty = tmp + sn + xn;
+    if (limbs_mul(sx, s, sn, x, xn) == ERROR || limbs_mul(ty, t, tn, y, yn) == ERROR) return ERROR;
+    size_t sxn = limbs_normalized_size(sx, sn + xn), tyn = limbs_normalized_size(ty, tn + yn);
+    if (sxn < tyn) {
+        limb_t *p = sx;
+        sx = ty;
+        ty = p;
+        size_t n = sxn;
+        sxn = tyn;
+        tyn = n;
+    }
+    if (sxn + 1 > cap) return ERROR;
+    r[sxn] = limbs_add(r, sx, sxn, ty, tyn);
+    *rn = limbs_normalized_size(r, sxn + 1);
+    return SUCCESS;
+}
+
+/*
+  Writes the next values of the batch that top has gone through on the remainders from limb p on,
+  ok is cleared if a remainder would not stay positive. The leading limbs of the new remainders are
+  the remainders of top, so only the limbs below p go through the products.
+*/
+static int8_t apply_n(struct gcd_state *st, const struct gcd_state *top, size_t p, bool *ok) {
+    const struct pair *u = &top->p[X_COFACTORS], *v = &top->p[Y_COFACTORS], *rt = &top->p[REMAINDERS];
+    size_t e = u->xn + v->xn + u->yn + v->yn;
+    limb_t *tmp = (limb_t *) scratch_alloc(sizeof(limb_t) * (e + 2 * st->cap));
+    if (tmp == NULL) return ERROR;
+
+    struct pair *r = &st->p[REMAINDERS];
+    size_t xn = limbs_normalized_size(r->x, p), yn = limbs_normalized_size(r->y, p), dn;
+    bool negative;
+    int k = top->parity & 1;
+    int8_t code = products_diff(u->x, u->xn, r->x, xn, v->x, v->xn, r->y, yn, tmp, &dn, &negative);
+    *ok = code == SUCCESS && shifted_sum(r->nx, &r->nxn, st->cap, rt->x, rt->xn, p, tmp, dn, negative != k);
+    if (*ok) code = products_diff(u->y, u->yn, r->x, xn, v->y, v->yn, r->y, yn, tmp, &dn, &negative);
+    *ok = *ok && code == SUCCESS &&
+          shifted_sum(r->ny, &r->nyn, st->cap, rt->y, rt->yn, p, tmp, dn, negative == k);
+
+    for (int i = 1; i < st->pairs && code == SUCCESS && *ok; i++) {
+        struct pair *c = &st->p[i];
+        code = products_sum(c->nx, &c->nxn, st->cap, u->x, u->xn, c->x, c->xn, v->x, v->xn, c->y, c->yn, tmp);
+        if (code == SUCCESS) {
+            code = products_sum(c->ny, &c->nyn, st->cap, u->y, u->yn, c->x, c->xn, v->y, v->yn, c->y, c->yn, tmp);
+        }
+    }
+    scratch_free(tmp);
+    return code;
+}
+
+static size_t largest_cofactor(const struct gcd_state *st) {
+    size_t e = 0;
+    for (int i = 1; i < st->pairs; i++) {
+        if (st->p[i].xn > e) e = st->p[i].xn;
+        if (st->p[i].yn > e) e = st->p[i].yn;
+    }
+    return e;
+}
+
+//one Lehmer batch or quotient, checked for dominance when the state is a half-GCD; committed tells if it was kept
+static int8_t gcd_step(struct gcd_state *st, bool *committed) {
+    limb_t e[4];
+    int k;
+    if (!lehmer_batch(st, e, &k) || !apply_1(st, e, k)) {
+        k = 1;
+        if (division_step(st) == ERROR) return ERROR;
+    }
+    *committed = st->pairs < 3 || dominates(st);
+    if (*committed) commit(st, k);
+    return SUCCESS;
+}
+
+static int8_t hgcd(struct gcd_state *st);
+
+//runs the half-GCD on the limbs of the remainders from p on and applies its batch to the full remainders
+static int8_t hgcd_top(struct gcd_state *st, size_t p, bool *progress) {
+    struct pair *r = &st->p[REMAINDERS];
+    *progress = false;
+    if (r->yn <= p) return SUCCESS;
+    struct gcd_state top;
+    if (init_state(&top, r->x + p, r->xn - p, r->y + p, limbs_normalized_size(r->y + p, r->yn - p), 3) == ERROR) {
+        return ERROR;
+    }
+    bool ok = false;
+    int8_t code = hgcd(&top);
+    if (code == SUCCESS && top.steps != 0) code = apply_n(st, &top, p, &ok);
+    if (code == SUCCESS && ok && (st->pairs < 3 || dominates(st))) {
+        commit(st, top.parity);
+        *progress = true;
+    }
+    scratch_free(top.storage);
+    return code;
+}
+
+/*
+  The first half-GCD on the leading half of the limbs leaves remainders of about 3/4 of the size with cofactors
+  of 1/4. The second one starts right above the cofactors, so what it adds to them is matched by the limbs
+  it keeps below, and the remainders end at about half the size with cofactors just as long.
+*/
+static int8_t hgcd(struct gcd_state *st) {
+    size_t m = st->p[REMAINDERS].xn;
+    bool progress = true;
+    if (m >= threshold_values[THRESHOLD_HGCD]) {
+        if (hgcd_top(st, m / 2, &progress) == ERROR) return ERROR;
+        if (hgcd_top(st, largest_cofactor(st) + 3, &progress) == ERROR) return ERROR;
+    }
+    for (bool committed = true; committed && !is_zero_limbs(st->p[REMAINDERS].y, st->p[REMAINDERS].yn);) {
+        if (gcd_step(st, &committed) == ERROR) return ERROR;
+    }
+    return SUCCESS;
+}
+
+static limb_t gcd_1(limb_t a, limb_t b) {
+    if (a == 0 || b == 0) return a | b;
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    do {
+        b >>= __builtin_ctzll(b);
+        if (a > b) {
+            limb_t t = a;
+            a = b;
+            b = t;
+        }
+        b -= a;
+    } while (b != 0);
+    return a << shift;
+}
+
+//runs Euclid to the end, the last remainder x is the gcd
+static int8_t gcd_reduce(struct gcd_state *st) {
+    struct pair *r = &st->p[REMAINDERS];
+    while (!is_zero_limbs(r->y, r->yn)) {
+        //without cofactors a single-limb y finishes in machine words
+        if (st->pairs == 1 && r->yn == 1) {
+            r->x[0] = gcd_1(r->y[0], limbs_divmod_1(r->nx, r->x, r->xn, r->y[0]));
+            r->xn = 1;
+            r->y[0] = 0;
+            break;
+        }
+        bool progress = false;
+        if (r->yn >= threshold_values[THRESHOLD_HGCD] && hgcd_top(st, r->xn / 3, &progress) == ERROR) return ERROR;
+        if (!progress && gcd_step(st, &progress) == ERROR) return ERROR;
+    }
+    return SUCCESS;
+}
+
+static int8_t set_limbs(BigNum num, const limb_t *a, size_t n, int sign) {
+    num->size_ = 0;
+    if (ReserveNum(num, n) == ERROR) return ERROR;
+    memcpy(num->limbs_, a, sizeof(limb_t) * n);
+    num->size_ = n;
+    num->sign_ = is_zero_limbs(a, n) ? 1 : sign;
+    return SUCCESS;
+}
+
+//g = gcd(x0, y0) for x0 >= y0, and when cofactor is given, g = cofactor * y0 mod x0
+static int8_t run_gcd(BigNum x0, BigNum y0, BigNum g, BigNum cofactor) {
+    struct gcd_state st;
+    if (init_state(&st, x0->limbs_, x0->size_, y0->limbs_, y0->size_, cofactor == NULL ? 1 : 2) == ERROR) {
+        return ERROR;
+    }
+    STAT_CALL(STAT_GCD, x0->size_);
+    int8_t code = STAT_TIMED(y0->size_ >= threshold_values[THRESHOLD_HGCD] ? STAT_GCD_HGCD : STAT_GCD_LEHMER,
+                             gcd_reduce(&st));
+    if (code == SUCCESS) code = set_limbs(g, st.p[REMAINDERS].x, st.p[REMAINDERS].xn, 1);
+    //x = (-1)^parity (u x0 - v y0)
+    if (code == SUCCESS && cofactor != NULL) {
+        code = set_limbs(cofactor, st.p[Y_COFACTORS].x, st.p[Y_COFACTORS].xn, st.parity ? 1 : -1);
+    }
+    scratch_free(st.storage);
+    return code;
+}
+
+//numbers that were never set count as 0
+int8_t GCD(BigNum lhs, BigNum rhs, BigNum res) {
+    if (lhs == NULL || rhs == NULL || res == NULL) return ERROR;
+    struct BigNum lhs_zero, rhs_zero;
+    lhs = num_or_zero(lhs, &lhs_zero);
+    rhs = num_or_zero(rhs, &rhs_zero);
+    if (lhs->size_ == 1 && rhs->size_ == 1) {
+        STAT_CALL(STAT_GCD, 1);
+        limb_t g = gcd_1(lhs->limbs_[0], rhs->limbs_[0]);
+        return set_limbs(res, &g, 1, 1);
+    }
+    if (limbs_cmp(lhs->limbs_, lhs->size_, rhs->limbs_, rhs->size_) == -1) return run_gcd(rhs, lhs, res, NULL);
+    return run_gcd(lhs, rhs, res, NULL);
+}
+
+int8_t ExtGCD(BigNum a, BigNum b, BigNum g, BigNum s, BigNum t) {
+    if (a == NULL || b == NULL || g == NULL || g == s || g == t || (s == t && s != NULL)) return ERROR;
+    struct BigNum a_zero, b_zero;
+    a = num_or_zero(a, &a_zero);
+    b = num_or_zero(b, &b_zero);
+    BigNum tg = CreateNum(), ts = CreateNum(), tt = CreateNum(), tmp = CreateNum();
+    int8_t code = tg == NULL || ts == NULL || tt == NULL || tmp == NULL ? ERROR : SUCCESS;
+    bool a_larger = limbs_cmp(a->limbs_, a->size_, b->limbs_, b->size_) != -1;
+
+    //one cofactor from the smaller input, then s with |s| <= |b| / 2g and t from g = s a + t b
+    if (code == SUCCESS) code = a_larger ? run_gcd(a, b, tg, tt) : run_gcd(b, a, tg, ts);
+    if (code == SUCCESS && num_is_zero(b)) {
+        code = set_limbs(ts, (const limb_t[]) {num_is_zero(a) ? 0 : 1}, 1, a->sign_);
+        if (code == SUCCESS) code = set_limbs(tt, (const limb_t[]) {0}, 1, 1);
+    } else if (code == SUCCESS) {
+        if (a_larger) {
+            tt->sign_ *= b->sign_;
+            if (Mult(tt, b, tmp) == ERROR || Sub(tg, tmp, tmp) == ERROR || Div(tmp, a, ts) == ERROR) code = ERROR;
+        } else {
+            ts->sign_ *= a->sign_;
+        }
+        //tmp = |b| / g, ts = ts mod tmp moved to (-tmp / 2, tmp / 2]
+        if (code == SUCCESS && (Abs(b, tmp) == ERROR || Div(tmp, tg, tmp) == ERROR || Mod(ts, tmp, ts) == ERROR)) {
+            code = ERROR;
+        }
+        if (code == SUCCESS) {
+            BigNum twice = tt;
+            if (Add(ts, ts, twice) == ERROR) code = ERROR;
+            if (code == SUCCESS && Compare(twice, tmp) == 1) code = Sub(ts, tmp, ts);
+        }
+        if (code == SUCCESS && (Mult(ts, a, tmp) == ERROR || Sub(tg, tmp, tmp) == ERROR || Div(tmp, b, tt) == ERROR)) {
+            code = ERROR;
+        }
+    }
+
+    if (code == SUCCESS) code = CopyNum(tg, g);
+    if (code == SUCCESS && s != NULL) code = CopyNum(ts, s);
+    if (code == SUCCESS && t != NULL) code = CopyNum(tt, t);
+    FreeNum(tg);
+    FreeNum(ts);
+    FreeNum(tt);
+    FreeNum(tmp);
+    return code;
+}
+
+int8_t ModInverse(BigNum a, BigNum mod, BigNum res) {
+    if (a == NULL || mod == NULL || res == NULL || num_is_zero(mod)) return ERROR;
+    struct BigNum a_zero;
+    a = num_or_zero(a, &a_zero);
+    BigNum m = CreateNum(), x = CreateNum(), g = CreateNum(), inverse = CreateNum();
+    int8_t code = m == NULL || x == NULL || g == NULL || inverse == NULL || Abs(mod, m) == ERROR ||
+                  Mod(a, m, x) == ERROR ? ERROR : SUCCESS;
+    //everything is the inverse of everything modulo 1
+    if (code == SUCCESS && m->size_ == 1 && m->limbs_[0] == 1) {
+        code = set_limbs(res, (const limb_t[]) {0}, 1, 1);
+    } else if (code == SUCCESS) {
+        code = run_gcd(m, x, g, inverse);
+        if (code == SUCCESS && (g->size_ != 1 || g->limbs_[0] != 1)) code = ERROR;
+        if (code == SUCCESS && inverse->sign_ == -1) code = Add(inverse, m, inverse);
+        if (code == SUCCESS) code = CopyNum(inverse, res);
+    }
+    FreeNum(m);
+    FreeNum(x);
+    FreeNum(g);
+    FreeNum(inverse);
+    return code;
+}
@@ -0,0 +1,142 @@
+#include "limbs.h"
+#include <string.h>
+
+//strips leading zero limbs, at least one limb is kept
+size_t limbs_normalized_size(const limb_t *a, size_t n) {
+    while (n > 1 && a[n - 1] == 0) {
+        n--;
+    }
+    return n;
+}
+
+int8_t limbs_cmp(const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    an = an == 0 ? 0 : limbs_normalized_size(a, an);
+    bn = bn == 0 ? 0 : limbs_normalized_size(b, bn);
+    if (an != bn) return an > bn ? 1 : -1;
+    for (size_t i = an; i-- > 0;) {
+        if (a[i] != b[i]) return a[i] > b[i] ? 1 : -1;
+    }
+    return 0;
+}
+
+//r = a + b over n limbs, returns carry; r may coincide with a or b
+limb_t limbs_add_n_generic(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    limb_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        limb_t s = a[i] + carry;
+        carry = s < carry;
+        r[i] = s + b[i];
+        carry += r[i] < s;
+    }
+    return carry;
+}
+
+//r = a - b over n limbs, returns borrow; r may coincide with a or b
+limb_t limbs_sub_n_generic(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        limb_t d = a[i] - b[i];
+        limb_t next = a[i] < b[i];
+        r[i] = d - borrow;
+        borrow = next | (d < borrow);
+    }
+    return borrow;
+}
+
+//r = a + b, an >= bn, returns carry
+limb_t limbs_add(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    limb_t carry = limbs_add_n(r, a, b, bn);
+    return limbs_add_1(r + bn, a + bn, an - bn, carry);
+}
+
+//r = a - b, a >= b, returns borrow
+limb_t limbs_sub(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    limb_t borrow = limbs_sub_n(r, a, b, bn);
+    return limbs_sub_1(r + bn, a + bn, an - bn, borrow);
+}
+
+//r = a + b, returns carry
+limb_t limbs_add_1(limb_t *r, const limb_t *a, size_t n, limb_t b) {
+    size_t i = 0;
+    for (; i < n && b != 0; i++) {
+        r[i] = a[i] + b;
+        b = r[i] < b;
+    }
+    if (r != a) memcpy(r + i, a + i, sizeof(limb_t) * (n - i));
+    return b;
+}
+
+//r = a - b, returns borrow
+limb_t limbs_sub_1(limb_t *r, const limb_t *a, size_t n, limb_t b) {
+    size_t i = 0;
+    for (; i < n && b != 0; i++) {
+        limb_t d = a[i] - b;
+        b = a[i] < b;
+        r[i] = d;
+    }
+    if (r != a) memcpy(r + i, a + i, sizeof(limb_t) * (n - i));
+    return b;
+}
+
+//r = a * m + c, returns the high limb; r may coincide with a
+limb_t limbs_mul_1_generic(limb_t *r, const limb_t *a, size_t n, limb_t m, limb_t c) {
+    for (size_t i = 0; i < n; i++) {
+        dlimb_t t = (dlimb_t) a[i] * m + c;
+        r[i] = (limb_t) t;
+        c = (limb_t) (t >> LIMB_BITS);
+    }
+    return c;
+}
+
+//r += a * m, returns the high limb
+limb_t limbs_addmul_1_generic(limb_t *r, const limb_t *a, size_t n, limb_t m) {
+    limb_t c = 0;
+    for (size_t i = 0; i < n; i++) {
+        dlimb_t t = (dlimb_t) a[i] * m + r[i] + c;
+        r[i] = (limb_t) t;
+        c = (limb_t) (t >> LIMB_BITS);
+    }
+    return c;
+}
+
+//r -= a * m, returns the borrow out of the top limb
+limb_t limbs_submul_1_generic(limb_t *r, const limb_t *a, size_t n, limb_t m) {
+    limb_t c = 0;
+    for (size_t i = 0; i < n; i++) {
+        dlimb_t t = (dlimb_t) a[i] * m + c;
+        limb_t lo = (limb_t) t;
+        c = (limb_t) (t >> LIMB_BITS) + (r[i] < lo);
+        r[i] -= lo;
+    }
+    return c;
+}
+
+//r = a << shift, 0 < shift < LIMB_BITS, returns the bits shifted out; r may coincide with a
+limb_t limbs_lshift(limb_t *r, const limb_t *a, size_t n, unsigned shift) {
+    limb_t out = a[n - 1] >> (LIMB_BITS - shift);
+    for (size_t i = n - 1; i > 0; i--) {
+        r[i] = (a[i] << shift) | (a[i - 1] >> (LIMB_BITS - shift));
+    }
+    r[0] = a[0] << shift;
+    return out;
+}
+
+//r = a >> shift, 0 < shift < LIMB_BITS; r may coincide with a
+void limbs_rshift(limb_t *r, const limb_t *a, size_t n, unsigned shift) {
+    for (size_t i = 0; i + 1 < n; i++) {
+        r[i] = (a[i] >> shift) | (a[i + 1] << (LIMB_BITS - shift));
+    }
+    r[n - 1] = a[n - 1] >> shift;
+}
+
+//q = a / d, returns a % d; q may coincide with a
+limb_t limbs_divmod_1(limb_t *q, const limb_t *a, size_t n, limb_t d) {
+    dlimb_t rem = 0;
+    for (size_t i = n; i-- > 0;) {
+        dlimb_t cur = (rem << LIMB_BITS) | a[i];
+        q[i] = (limb_t) (cur / d);
+        rem = cur % d;
+    }
+    return (limb_t) rem;
+}
+
@@ -0,0 +1,218 @@
+#ifndef ARBITARYPRECISIONARITHMETICS_LIMBS_H
+#define ARBITARYPRECISIONARITHMETICS_LIMBS_H
+
+#include "number.h"
+
+//internal routines working on raw little-endian limb arrays, arrays may contain leading zeroes
+
+typedef unsigned __int128 dlimb_t;
+
+size_t limbs_normalized_size(const limb_t *a, size_t n);
+
+int8_t limbs_cmp(const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+/*
+  Kernels with several implementations, cpu.c picks the fastest one for the running CPU at load.
+  Every variant allows r to coincide with a or b.
+*/
+struct limb_kernels {
+    limb_t (*add_n)(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+    limb_t (*sub_n)(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+    limb_t (*mul_1)(limb_t *r, const limb_t *a, size_t n, limb_t m, limb_t c);
+    limb_t (*addmul_1)(limb_t *r, const limb_t *a, size_t n, limb_t m);
+    limb_t (*submul_1)(limb_t *r, const limb_t *a, size_t n, limb_t m);
+};
+
+enum kernel_set {
+    KERNELS_GENERIC, //portable C
+    KERNELS_X86_64, //carry flag intrinsics, baseline x86-64
+    KERNELS_MULX, //MULX with the two ADCX/ADOX carry chains for the products, needs BMI2 and ADX
+    KERNELS_AVX2, //also needs the instructions of KERNELS_MULX
+    KERNELS_AVX512,
+    KERNEL_SETS_COUNT
+};
+
+extern struct limb_kernels limb_kernels;
+
+//the set limb_kernels was filled from, code outside the table picks its own variants by it
+extern enum kernel_set limb_kernel_set;
+
+//ERROR if the CPU lacks the instructions of the set
+int8_t limbs_use_kernels(enum kernel_set set);
+
+enum kernel_set limbs_best_kernels();
+
+limb_t limbs_add_n_generic(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+limb_t limbs_sub_n_generic(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+limb_t limbs_mul_1_generic(limb_t *r, const limb_t *a, size_t n, limb_t m, limb_t c);
+
+limb_t limbs_addmul_1_generic(limb_t *r, const limb_t *a, size_t n, limb_t m);
+
+limb_t limbs_submul_1_generic(limb_t *r, const limb_t *a, size_t n, limb_t m);
+
+#if defined(__x86_64__)
+limb_t limbs_add_n_x86_64(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+limb_t limbs_sub_n_x86_64(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+limb_t limbs_add_n_avx2(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+limb_t limbs_sub_n_avx2(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+limb_t limbs_add_n_avx512(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+limb_t limbs_sub_n_avx512(limb_t *r, const limb_t *a, const limb_t *b, size_t n);
+
+limb_t limbs_mul_1_mulx(limb_t *r, const limb_t *a, size_t n, limb_t m, limb_t c);
+
+limb_t limbs_addmul_1_mulx(limb_t *r, const limb_t *a, size_t n, limb_t m);
+
+limb_t limbs_submul_1_mulx(limb_t *r, const limb_t *a, size_t n, limb_t m);
+#endif
+
+static inline limb_t limbs_add_n(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    return limb_kernels.add_n(r, a, b, n);
+}
+
+static inline limb_t limbs_sub_n(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    return limb_kernels.sub_n(r, a, b, n);
+}
+
+static inline limb_t limbs_mul_1(limb_t *r, const limb_t *a, size_t n, limb_t m, limb_t c) {
+    return limb_kernels.mul_1(r, a, n, m, c);
+}
+
+static inline limb_t limbs_addmul_1(limb_t *r, const limb_t *a, size_t n, limb_t m) {
+    return limb_kernels.addmul_1(r, a, n, m);
+}
+
+static inline limb_t limbs_submul_1(limb_t *r, const limb_t *a, size_t n, limb_t m) {
+    return limb_kernels.submul_1(r, a, n, m);
+}
+
+limb_t limbs_add(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+limb_t limbs_sub(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+limb_t limbs_add_1(limb_t *r, const limb_t *a, size_t n, limb_t b);
+
+limb_t limbs_sub_1(limb_t *r, const limb_t *a, size_t n, limb_t b);
+
+limb_t limbs_lshift(limb_t *r, const limb_t *a, size_t n, unsigned shift);
+
+void limbs_rshift(limb_t *r, const limb_t *a, size_t n, unsigned shift);
+
+limb_t limbs_divmod_1(limb_t *q, const limb_t *a, size_t n, limb_t d);
+
+void limbs_mul_basecase(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+void limbs_sqr_basecase(limb_t *r, const limb_t *a, size_t n);
+
+int8_t limbs_sqr(limb_t *r, const limb_t *a, size_t n);
+
+int8_t limbs_mul_ntt(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+int8_t limbs_mul(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn);
+
+//signed accumulators in the form of a BigNum, see mult.c
+void limbs_acc_add(limb_t *r, size_t *rn, int *r_sign, const limb_t *a, size_t an, int sign);
+
+int8_t limbs_acc_addmul(limb_t *r, size_t *rn, int *r_sign, const limb_t *a, size_t an, const limb_t *b, size_t bn,
+                        int sign, limb_t *tmp);
+
+int8_t limbs_divmod(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *d, size_t dn);
+
+void limbs_divmod_basecase(limb_t *q, limb_t *r, const limb_t *a, size_t an, const limb_t *d, size_t dn, limb_t *tmp);
+
+//precomputed data of a divisor d, see div.c
+struct Divisor {
+    size_t n;
+    int sign;
+    unsigned shift; //norm = |d| << shift has the top bit set
+    limb_t inv; //reciprocal of the top limb of norm, or of its top two limbs when n > 1
+    limb_t *d; //|d|, n limbs
+    limb_t *norm; //n limbs
+};
+
+int8_t limbs_divmod_by(limb_t *q, limb_t *r, const limb_t *a, size_t an, const struct Divisor *d);
+
+//36 for characters that are not digits of any base
+int limbs_digit_value(char c);
+
+size_t limbs_size_for_digits(size_t len, int base);
+
+size_t limbs_digits_bound(size_t n, int base);
+
+int8_t limbs_from_str(limb_t *r, size_t *rn, const char *str, size_t len, int base);
+
+//receives digits most significant first
+struct digit_sink {
+    int8_t (*write)(struct digit_sink *sink, const char *digits, size_t len);
+};
+
+int8_t limbs_to_str(struct digit_sink *sink, const limb_t *a, size_t n, int base);
+
+//fills buf with up to cap valid digits, fewer only once the digits are over, sets code on failure
+struct digit_source {
+    size_t (*read)(struct digit_source *source, char *buf, size_t cap);
+    int8_t code;
+};
+
+int8_t limbs_from_source(limb_t **r, size_t *rn, struct digit_source *source, int base);
+
+//precomputed data of a modulus m, see powmod.c
+struct ModCtx {
+    size_t n;
+    bool montgomery;
+    limb_t minv; //-m^-1 mod B
+    size_t mun;
+    limb_t *m; //n limbs, the top one is not zero
+    limb_t *r2; //B^2n mod m, n limbs
+    limb_t *mu; //B^2n / m, mun <= n + 2 limbs
+};
+
+//storage of numbers, carries a header so that num_free finds the owning context
+void *num_alloc(NumCtx ctx, size_t size);
+
+void *num_realloc(NumCtx ctx, void *ptr, size_t size);
+
+void num_free(void *ptr);
+
+//frees what num owns and leaves it with empty inline storage
+void num_release_storage(BigNum num);
+
+//true for 0 and for a number that was never set
+bool num_is_zero(BigNum num);
+
+//num, or zero made to hold 0 if num was never set
+BigNum num_or_zero(BigNum num, struct BigNum *zero);
+
+//short-lived buffers of the limb routines, straight from the hooks
+void *scratch_alloc(size_t size);
+
+void scratch_free(void *ptr);
+
+extern size_t threshold_values[THRESHOLDS_COUNT];
+
+//a unit of work for the pool of the calling thread, see pool.c
+struct task {
+    int8_t (*run)(void *arg);
+    void *arg;
+    int8_t code;
+};
+
+//true if the pool of the calling thread takes work of this many limbs
+bool parallel_worth(size_t limbs);
+
+//threads of the pool of the calling thread, 1 without a pool
+size_t parallel_threads();
+
+//runs the tasks, on the pool if there is one, and returns ERROR if any of them failed
+int8_t parallel_run(struct task *tasks, size_t count);
+
+//body over [0, count) in ranges of at least min_chunk, one per thread, ERROR if any range failed
+int8_t parallel_for(size_t count, size_t min_chunk, int8_t (*body)(void *ctx, size_t begin, size_t end), void *ctx);
+
+#endif //ARBITARYPRECISIONARITHMETICS_LIMBS_H
@@ -0,0 +1,258 @@
+#include "limbs.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+/*
+  The vector kernels add whole registers lane by lane and resolve the carries with mask arithmetic:
+  a lane generates a carry when its sum wraps and propagates an incoming one when its sum is all ones.
+  The two never happen in the same lane, so adding the shifted generate mask to the propagate mask
+  ripples every carry through its chain, and the bits that flipped are the lanes that take a carry.
+  Subtraction is the same with borrows, a lane propagates when its difference is zero.
+*/
+
+typedef unsigned long long *u64_ptr;
+
+//the scalar chains take a carry in, so the vector kernels can hand over their tails without a branch
+static limb_t add_n_carry(limb_t *r, const limb_t *a, const limb_t *b, size_t n, unsigned char carry) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        carry = _addcarry_u64(carry, a[i], b[i], (u64_ptr) &r[i]);
+        carry = _addcarry_u64(carry, a[i + 1], b[i + 1], (u64_ptr) &r[i + 1]);
+        carry = _addcarry_u64(carry, a[i + 2], b[i + 2], (u64_ptr) &r[i + 2]);
+        carry = _addcarry_u64(carry, a[i + 3], b[i + 3], (u64_ptr) &r[i + 3]);
+    }
+    for (; i < n; i++) {
+        carry = _addcarry_u64(carry, a[i], b[i], (u64_ptr) &r[i]);
+    }
+    return carry;
+}
+
+static limb_t sub_n_borrow(limb_t *r, const limb_t *a, const limb_t *b, size_t n, unsigned char borrow) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        borrow = _subborrow_u64(borrow, a[i], b[i], (u64_ptr) &r[i]);
+        borrow = _subborrow_u64(borrow, a[i + 1], b[i + 1], (u64_ptr) &r[i + 1]);
+        borrow = _subborrow_u64(borrow, a[i + 2], b[i + 2], (u64_ptr) &r[i + 2]);
+        borrow = _subborrow_u64(borrow, a[i + 3], b[i + 3], (u64_ptr) &r[i + 3]);
+    }
+    for (; i < n; i++) {
+        borrow = _subborrow_u64(borrow, a[i], b[i], (u64_ptr) &r[i]);
+    }
+    return borrow;
+}
+
+limb_t limbs_add_n_x86_64(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    return add_n_carry(r, a, b, n, 0);
+}
+
+limb_t limbs_sub_n_x86_64(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    return sub_n_borrow(r, a, b, n, 0);
+}
+
+//AVX2 has neither unsigned compares nor mask registers, so lanes are flipped by the sign bit and masks go through movemask
+__attribute__((target("avx2")))
+limb_t limbs_add_n_avx2(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    const __m256i sign = _mm256_set1_epi64x((long long) 0x8000000000000000ull);
+    const __m256i all = _mm256_set1_epi64x(-1);
+    const __m256i lanes = _mm256_setr_epi64x(1, 2, 4, 8);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        __m256i s = _mm256_add_epi64(x, y);
+        __m256i wrapped = _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(s, sign));
+        unsigned generate = (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(wrapped));
+        unsigned propagate = (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(s, all)));
+        unsigned chain = ((generate << 1) | carry) + propagate;
+        carry = chain >> 4;
+        __m256i take = _mm256_set1_epi64x((long long) ((chain ^ propagate) & 15));
+        take = _mm256_cmpeq_epi64(_mm256_and_si256(take, lanes), lanes);
+        _mm256_storeu_si256((__m256i *) (r + i), _mm256_sub_epi64(s, take));
+    }
+    return add_n_carry(r + i, a + i, b + i, n - i, (unsigned char) carry);
+}
+
+__attribute__((target("avx2")))
+limb_t limbs_sub_n_avx2(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    const __m256i sign = _mm256_set1_epi64x((long long) 0x8000000000000000ull);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lanes = _mm256_setr_epi64x(1, 2, 4, 8);
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (b + i));
+        __m256i d = _mm256_sub_epi64(x, y);
+        __m256i wrapped = _mm256_cmpgt_epi64(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign));
+        unsigned generate = (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(wrapped));
+        unsigned propagate = (unsigned) _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(d, zero)));
+        unsigned chain = ((generate << 1) | borrow) + propagate;
+        borrow = chain >> 4;
+        __m256i take = _mm256_set1_epi64x((long long) ((chain ^ propagate) & 15));
+        take = _mm256_cmpeq_epi64(_mm256_and_si256(take, lanes), lanes);
+        _mm256_storeu_si256((__m256i *) (r + i), _mm256_add_epi64(d, take));
+    }
+    return sub_n_borrow(r + i, a + i, b + i, n - i, (unsigned char) borrow);
+}
+
+__attribute__((target("avx512f")))
+limb_t limbs_add_n_avx512(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    const __m512i one = _mm512_set1_epi64(1);
+    const __m512i all = _mm512_set1_epi64(-1);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i s = _mm512_add_epi64(x, _mm512_loadu_si512(b + i));
+        unsigned generate = _mm512_cmplt_epu64_mask(s, x);
+        unsigned propagate = _mm512_cmpeq_epi64_mask(s, all);
+        unsigned chain = ((generate << 1) | carry) + propagate;
+        carry = chain >> 8;
+        s = _mm512_mask_add_epi64(s, (__mmask8) (chain ^ propagate), s, one);
+        _mm512_storeu_si512(r + i, s);
+    }
+    return add_n_carry(r + i, a + i, b + i, n - i, (unsigned char) carry);
+}
+
+__attribute__((target("avx512f")))
+limb_t limbs_sub_n_avx512(limb_t *r, const limb_t *a, const limb_t *b, size_t n) {
+    const __m512i one = _mm512_set1_epi64(1);
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        __m512i d = _mm512_sub_epi64(x, y);
+        unsigned generate = _mm512_cmplt_epu64_mask(x, y);
+        unsigned propagate = _mm512_cmpeq_epi64_mask(d, _mm512_setzero_si512());
+        unsigned chain = ((generate << 1) | borrow) + propagate;
+        borrow = chain >> 8;
+        d = _mm512_mask_sub_epi64(d, (__mmask8) (chain ^ propagate), d, one);
+        _mm512_storeu_si512(r + i, d);
+    }
+    return sub_n_borrow(r + i, a + i, b + i, n - i, (unsigned char) borrow);
+}
+
+/*
+  The product kernels run four limbs per asm block. MULX leaves the flags alone, so the high halves
+  are added in with ADOX on the overflow flag while ADCX folds the result into r on the carry flag,
+  and the two chains never wait for each other. SBB would clobber the overflow flag, so submul adds the
+  complement with the carry flag set instead. Both flags are drained into the returned limb at the end of a block.
+*/
+
+limb_t limbs_mul_1_mulx(limb_t *r, const limb_t *a, size_t n, limb_t m, limb_t c) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        limb_t lo, hi, next;
+        __asm__ volatile(
+                "xor %k[next], %k[next]\n\t"
+                "mulx (%[a]), %[lo], %[hi]\n\t"
+                "adcx %[c], %[lo]\n\t"
+                "mov %[lo], (%[r])\n\t"
+                "mulx 8(%[a]), %[lo], %[next]\n\t"
+                "adcx %[hi], %[lo]\n\t"
+                "mov %[lo], 8(%[r])\n\t"
+                "mulx 16(%[a]), %[lo], %[hi]\n\t"
+                "adcx %[next], %[lo]\n\t"
+                "mov %[lo], 16(%[r])\n\t"
+                "mulx 24(%[a]), %[lo], %[next]\n\t"
+                "adcx %[hi], %[lo]\n\t"
+                "mov %[lo], 24(%[r])\n\t"
+                "mov $0, %k[hi]\n\t"
+                "adcx %[hi], %[next]"
+                : [lo] "=&r"(lo), [hi] "=&r"(hi), [next] "=&r"(next)
+                : [a] "r"(a + i), [r] "r"(r + i), [c] "r"(c), "d"(m)
+                : "cc", "memory");
+        c = next;
+    }
+    return limbs_mul_1_generic(r + i, a + i, n - i, m, c);
+}
+
+limb_t limbs_addmul_1_mulx(limb_t *r, const limb_t *a, size_t n, limb_t m) {
+    limb_t c = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        limb_t lo, hi, next;
+        __asm__ volatile(
+                "xor %k[next], %k[next]\n\t"
+                "mulx (%[a]), %[lo], %[hi]\n\t"
+                "adox %[c], %[lo]\n\t"
+                "adcx (%[r]), %[lo]\n\t"
+                "mov %[lo], (%[r])\n\t"
+                "mulx 8(%[a]), %[lo], %[next]\n\t"
+                "adox %[hi], %[lo]\n\t"
+                "adcx 8(%[r]), %[lo]\n\t"
+                "mov %[lo], 8(%[r])\n\t"
+                "mulx 16(%[a]), %[lo], %[hi]\n\t"
+                "adox %[next], %[lo]\n\t"
+                "adcx 16(%[r]), %[lo]\n\t"
+                "mov %[lo], 16(%[r])\n\t"
+                "mulx 24(%[a]), %[lo], %[next]\n\t"
+                "adox %[hi], %[lo]\n\t"
+                "adcx 24(%[r]), %[lo]\n\t"
+                "mov %[lo], 24(%[r])\n\t"
+                "mov $0, %k[hi]\n\t"
+                "adox %[hi], %[next]\n\t"
+                "adcx %[hi], %[next]"
+                : [lo] "=&r"(lo), [hi] "=&r"(hi), [next] "=&r"(next)
+                : [a] "r"(a + i), [r] "r"(r + i), [c] "r"(c), "d"(m)
+                : "cc", "memory");
+        c = next;
+    }
+    for (; i < n; i++) {
+        dlimb_t t = (dlimb_t) a[i] * m + r[i] + c;
+        r[i] = (limb_t) t;
+        c = (limb_t) (t >> LIMB_BITS);
+    }
+    return c;
+}
+
+limb_t limbs_submul_1_mulx(limb_t *r, const limb_t *a, size_t n, limb_t m) {
+    limb_t c = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        limb_t lo, hi, next;
+        __asm__ volatile(
+                "xor %k[next], %k[next]\n\t"
+                "stc\n\t"
+                "mulx (%[a]), %[lo], %[hi]\n\t"
+                "adox %[c], %[lo]\n\t"
+                "not %[lo]\n\t"
+                "adcx (%[r]), %[lo]\n\t"
+                "mov %[lo], (%[r])\n\t"
+                "mulx 8(%[a]), %[lo], %[next]\n\t"
+                "adox %[hi], %[lo]\n\t"
+                "not %[lo]\n\t"
+                "adcx 8(%[r]), %[lo]\n\t"
+                "mov %[lo], 8(%[r])\n\t"
+                "mulx 16(%[a]), %[lo], %[hi]\n\t"
+                "adox %[next], %[lo]\n\t"
+                "not %[lo]\n\t"
+                "adcx 16(%[r]), %[lo]\n\t"
+                "mov %[lo], 16(%[r])\n\t"
+                "mulx 24(%[a]), %[lo], %[next]\n\t"
+                "adox %[hi], %[lo]\n\t"
+                "not %[lo]\n\t"
+                "adcx 24(%[r]), %[lo]\n\t"
+                "mov %[lo], 24(%[r])\n\t"
+                "mov $0, %k[hi]\n\t"
+                "adox %[hi], %[next]\n\t"
+                "cmc\n\t"
+                "adc %[hi], %[next]"
+                : [lo] "=&r"(lo), [hi] "=&r"(hi), [next] "=&r"(next)
+                : [a] "r"(a + i), [r] "r"(r + i), [c] "r"(c), "d"(m)
+                : "cc", "memory");
+        c = next;
+    }
+    for (; i < n; i++) {
+        dlimb_t t = (dlimb_t) a[i] * m + c;
+        limb_t lo = (limb_t) t;
+        c = (limb_t) (t >> LIMB_BITS) + (r[i] < lo);
+        r[i] -= lo;
+    }
+    return c;
+}
+
+#endif
@@ -0,0 +1,451 @@
+#include "limbs.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define swap(T, x, y) \
+    {                 \
+        T obj = (x);  \
+        (x) = (y);    \
+        (y) = obj;    \
+    }
+
+//r = a * b, r has an + bn limbs and must not overlap a or b
+void limbs_mul_basecase(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    r[an] = limbs_mul_1(r, a, an, b[0], 0);
+    for (size_t j = 1; j < bn; j++) {
+        r[an + j] = limbs_addmul_1(r + j, a, an, b[j]);
+    }
+}
+
+//r = a^2, r has 2n limbs and must not overlap a; every cross product is computed once and doubled
+void limbs_sqr_basecase(limb_t *r, const limb_t *a, size_t n) {
+    r[0] = 0;
+    r[n] = limbs_mul_1(r + 1, a + 1, n - 1, a[0], 0);
+    for (size_t i = 1; i + 1 < n; i++) {
+        r[n + i] = limbs_addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    r[2 * n - 1] = 0;
+    limbs_lshift(r, r, 2 * n, 1);
+    limb_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        dlimb_t square = (dlimb_t) a[i] * a[i];
+        dlimb_t t = (dlimb_t) r[2 * i] + (limb_t) square + carry;
+        r[2 * i] = (limb_t) t;
+        t = (dlimb_t) r[2 * i + 1] + (limb_t) (square >> LIMB_BITS) + (limb_t) (t >> LIMB_BITS);
+        r[2 * i + 1] = (limb_t) t;
+        carry = (limb_t) (t >> LIMB_BITS);
+    }
+}
+
+//r[off..rn) += x, the caller guarantees that the sum fits into rn limbs
+static void add_at(limb_t *r, size_t rn, size_t off, const limb_t *x, size_t xn) {
+    xn = limbs_normalized_size(x, xn);
+    if (xn > rn - off) xn = rn - off;
+    limb_t carry = limbs_add(r + off, r + off, xn, x, xn);
+    limbs_add_1(r + off + xn, r + off + xn, rn - off - xn, carry);
+}
+
+//one product of a group that may run on the pool
+struct product {
+    limb_t *r;
+    const limb_t *a;
+    size_t an;
+    const limb_t *b;
+    size_t bn;
+};
+
+static int8_t run_product(void *arg) {
+    struct product *p = (struct product *) arg;
+    return limbs_mul(p->r, p->a, p->an, p->b, p->bn);
+}
+
+//products with disjoint results, in parallel when the smaller operand of the caller, limbs, is large enough
+static int8_t mul_group(struct product *products, size_t count, size_t limbs) {
+    if (!parallel_worth(limbs)) {
+        for (size_t i = 0; i < count; i++) {
+            if (run_product(&products[i]) == ERROR) return ERROR;
+        }
+        return SUCCESS;
+    }
+    struct task *tasks = (struct task *) scratch_alloc(sizeof(struct task) * count);
+    if (tasks == NULL) return ERROR;
+    for (size_t i = 0; i < count; i++) {
+        tasks[i] = (struct task) {run_product, &products[i], SUCCESS};
+    }
+    int8_t code = parallel_run(tasks, count);
+    scratch_free(tasks);
+    return code;
+}
+
+/*
+  On a pool the pieces are independent: even pieces go straight into r, odd ones into a buffer
+  that is added at the end.
+*/
+static int8_t mul_unbalanced_parallel(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    size_t pieces = (an + bn - 1) / bn;
+    limb_t *odd = (limb_t *) scratch_alloc(sizeof(limb_t) * an);
+    struct product *products = (struct product *) scratch_alloc(sizeof(struct product) * pieces);
+    if (odd == NULL || products == NULL) {
+        scratch_free(odd);
+        scratch_free(products);
+        return ERROR;
+    }
+    //odd[i] stands for r[bn + i]
+    for (size_t i = 0; i < pieces; i++) {
+        size_t off = i * bn, cn = an - off < bn ? an - off : bn;
+        limb_t *dst = i % 2 == 0 ? r + off : odd + off - bn;
+        products[i] = (struct product) {dst, b, bn, a + off, cn};
+    }
+    //the last piece of each kind ends where its product does, the rest stays zero
+    size_t even_end = pieces % 2 == 0 ? pieces * bn : an + bn, odd_end = pieces % 2 == 0 ? an : (pieces - 1) * bn;
+    memset(r + even_end, 0, sizeof(limb_t) * (an + bn - even_end));
+    memset(odd + odd_end, 0, sizeof(limb_t) * (an - odd_end));
+    int8_t code = mul_group(products, pieces, bn);
+    if (code == SUCCESS) limbs_add_n(r + bn, r + bn, odd, an);
+    scratch_free(odd);
+    scratch_free(products);
+    return code;
+}
+
+//bn <= an / 2: a is cut into bn-limb pieces, so the short operand is never padded
+static int8_t mul_unbalanced(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    if (parallel_worth(bn)) return mul_unbalanced_parallel(r, a, an, b, bn);
+    limb_t *tmp = (limb_t *) scratch_alloc(sizeof(limb_t) * 2 * bn);
+    if (tmp == NULL || limbs_mul(r, a, bn, b, bn) == ERROR) {
+        scratch_free(tmp);
+        return ERROR;
+    }
+    for (size_t off = bn; off < an; off += bn) {
+        size_t cn = an - off < bn ? an - off : bn;
+        if (limbs_mul(tmp, b, bn, a + off, cn) == ERROR) {
+            scratch_free(tmp);
+            return ERROR;
+        }
+        //r[off..off + bn) still holds the upper half of the previous pieces
+        limbs_add(r + off, tmp, cn + bn, r + off, bn);
+    }
+    scratch_free(tmp);
+    return SUCCESS;
+}
+
+/*
+  a = a1 * B^h + a0, b = b1 * B^h + b0
+  a * b = z2 * B^2h + ((a0 + a1) * (b0 + b1) - z2 - z0) * B^h + z0
+*/
+static int8_t mul_karatsuba(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    size_t h = (an + 1) / 2;
+    size_t a1n = an - h, b1n = bn - h;
+    limb_t *scratch = (limb_t *) scratch_alloc(sizeof(limb_t) * (4 * h + 4));
+    if (scratch == NULL) return ERROR;
+    limb_t *sa = scratch, *sb = scratch + h + 1, *t = scratch + 2 * h + 2;
+
+    sa[h] = limbs_add(sa, a, h, a + h, a1n);
+    sb[h] = limbs_add(sb, b, h, b + h, b1n);
+    size_t san = limbs_normalized_size(sa, h + 1), sbn = limbs_normalized_size(sb, h + 1);
+    memset(t + san + sbn, 0, sizeof(limb_t) * (2 * h + 2 - san - sbn));
+
+    struct product products[3] = {{r, a, h, b, h}, {r + 2 * h, a + h, a1n, b + h, b1n}, {t, sa, san, sb, sbn}};
+    if (mul_group(products, 3, bn) == ERROR) {
+        scratch_free(scratch);
+        return ERROR;
+    }
+    limbs_sub(t, t, 2 * h + 2, r, 2 * h);
+    limbs_sub(t, t, 2 * h + 2, r + 2 * h, a1n + b1n);
+    add_at(r, an + bn, h, t, 2 * h + 2);
+    scratch_free(scratch);
+    return SUCCESS;
+}
+
+/*
+  a = a1 * B^h + a0
+  a^2 = a1^2 * B^2h + (a0^2 + a1^2 - (a0 - a1)^2) * B^h + a0^2
+  the difference is squared, so its sign does not matter and no carry limb is needed
+*/
+static int8_t sqr_karatsuba(limb_t *r, const limb_t *a, size_t n) {
+    size_t h = (n + 1) / 2;
+    size_t a1n = n - h;
+    limb_t *scratch = (limb_t *) scratch_alloc(sizeof(limb_t) * (5 * h + 1));
+    if (scratch == NULL) return ERROR;
+    limb_t *d = scratch, *t = scratch + h, *mid = scratch + 3 * h;
+
+    if (limbs_cmp(a, h, a + h, a1n) != -1) {
+        limbs_sub(d, a, h, a + h, a1n);
+    } else {
+        memset(d + a1n, 0, sizeof(limb_t) * (h - a1n));
+        limbs_sub(d, a + h, a1n, a, a1n);
+    }
+    size_t dn = limbs_normalized_size(d, h);
+    memset(t + 2 * dn, 0, sizeof(limb_t) * (2 * h - 2 * dn));
+
+    //products of an operand with itself are squares
+    struct product products[3] = {{r, a, h, a, h}, {r + 2 * h, a + h, a1n, a + h, a1n}, {t, d, dn, d, dn}};
+    if (mul_group(products, 3, n) == ERROR) {
+        scratch_free(scratch);
+        return ERROR;
+    }
+    mid[2 * h] = limbs_add(mid, r, 2 * h, r + 2 * h, 2 * a1n);
+    limbs_sub(mid, mid, 2 * h + 1, t, 2 * h);
+    add_at(r, 2 * n, h, mid, 2 * h + 1);
+    scratch_free(scratch);
+    return SUCCESS;
+}
+
+//signed scratch value used by the Toom-3 evaluation and interpolation
+struct svalue {
+    limb_t *limbs;
+    size_t size;
+    int sign;
+};
+
+static struct svalue sv_view(const limb_t *a, size_t n) {
+    struct svalue v = {(limb_t *) a, limbs_normalized_size(a, n), 1};
+    return v;
+}
+
+static void sv_fix_zero(struct svalue *r) {
+    r->size = limbs_normalized_size(r->limbs, r->size);
+    if (r->size == 1 && r->limbs[0] == 0) r->sign = 1;
+}
+
+//r = x + y_sign * y, r may coincide with x or y
+static void sv_add(struct svalue *r, const struct svalue *x, const struct svalue *y, int y_sign) {
+    int xs = x->sign, ys = y->sign * y_sign;
+    size_t xn = x->size, yn = y->size;
+    const limb_t *xl = x->limbs, *yl = y->limbs;
+    if (xs == ys) {
+        if (xn < yn) {
+            swap(const limb_t *, xl, yl);
+            swap(size_t, xn, yn);
+        }
+        limb_t carry = limbs_add(r->limbs, xl, xn, yl, yn);
+        r->size = xn;
+        if (carry != 0) r->limbs[r->size++] = carry;
+        r->sign = xs;
+    } else if (limbs_cmp(xl, xn, yl, yn) != -1) {
+        limbs_sub(r->limbs, xl, xn, yl, yn);
+        r->size = xn;
+        r->sign = xs;
+    } else {
+        limbs_sub(r->limbs, yl, yn, xl, xn);
+        r->size = yn;
+        r->sign = ys;
+    }
+    sv_fix_zero(r);
+}
+
+static void sv_shl1(struct svalue *r) {
+    limb_t carry = limbs_add(r->limbs, r->limbs, r->size, r->limbs, r->size);
+    if (carry != 0) r->limbs[r->size++] = carry;
+}
+
+//r is known to be even
+static void sv_shr1(struct svalue *r) {
+    for (size_t i = 0; i + 1 < r->size; i++) {
+        r->limbs[i] = (r->limbs[i] >> 1) | (r->limbs[i + 1] << (LIMB_BITS - 1));
+    }
+    r->limbs[r->size - 1] >>= 1;
+    sv_fix_zero(r);
+}
+
+//r is known to be a multiple of 3
+static void sv_divexact_3(struct svalue *r) {
+    limbs_divmod_1(r->limbs, r->limbs, r->size, 3);
+    sv_fix_zero(r);
+}
+
+//r = x * y as a product of a group, sv_mul_done completes r once the group has run
+static struct product sv_mul(struct svalue *r, const struct svalue *x, const struct svalue *y) {
+    struct product p = {r->limbs, x->limbs, x->size, y->limbs, y->size};
+    return p;
+}
+
+static void sv_mul_done(struct svalue *r, const struct svalue *x, const struct svalue *y) {
+    r->size = x->size + y->size;
+    r->sign = x->sign * y->sign;
+    sv_fix_zero(r);
+}
+
+//v(1), v(-1) and v(-2) of v0 + v1 * x + v2 * x^2, every output needs k + 2 limbs
+static void toom3_evaluate(const limb_t *v, size_t n, size_t k, struct svalue *p1, struct svalue *pm1,
+                           struct svalue *pm2) {
+    struct svalue v0 = sv_view(v, k), v1 = sv_view(v + k, k), v2 = sv_view(v + 2 * k, n - 2 * k);
+    sv_add(pm2, &v0, &v2, 1);
+    sv_add(p1, pm2, &v1, 1);
+    sv_add(pm1, pm2, &v1, -1);
+    sv_add(pm2, pm1, &v2, 1);
+    sv_shl1(pm2);
+    sv_add(pm2, pm2, &v0, -1);
+}
+
+//Toom-3 with the evaluation points 0, 1, -1, -2, inf and Bodrato's interpolation sequence, a == b squares
+static int8_t mul_toom3(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    size_t k = (an + 2) / 3;
+    size_t rn = an + bn;
+    size_t eval_cap = k + 2, prod_cap = 2 * k + 4;
+    limb_t *scratch = (limb_t *) scratch_alloc(sizeof(limb_t) * (6 * eval_cap + 4 * prod_cap));
+    if (scratch == NULL) return ERROR;
+
+    struct svalue ev[6], pr[4];
+    for (int i = 0; i < 6; i++) {
+        ev[i].limbs = scratch + i * eval_cap;
+    }
+    for (int i = 0; i < 4; i++) {
+        pr[i].limbs = scratch + 6 * eval_cap + i * prod_cap;
+    }
+    toom3_evaluate(a, an, k, &ev[0], &ev[1], &ev[2]);
+    if (a == b && an == bn) {
+        ev[3] = ev[0];
+        ev[4] = ev[1];
+        ev[5] = ev[2];
+    } else {
+        toom3_evaluate(b, bn, k, &ev[3], &ev[4], &ev[5]);
+    }
+
+    struct svalue *r1 = &pr[0], *rm1 = &pr[1], *r3 = &pr[2], *r2 = &pr[3];
+    struct product products[5] = {{r, a, k, b, k}, {r + 4 * k, a + 2 * k, an - 2 * k, b + 2 * k, bn - 2 * k},
+                                  sv_mul(r1, &ev[0], &ev[3]), sv_mul(rm1, &ev[1], &ev[4]), sv_mul(r3, &ev[2], &ev[5])};
+    if (mul_group(products, 5, bn) == ERROR) {
+        scratch_free(scratch);
+        return ERROR;
+    }
+    sv_mul_done(r1, &ev[0], &ev[3]);
+    sv_mul_done(rm1, &ev[1], &ev[4]);
+    sv_mul_done(r3, &ev[2], &ev[5]);
+    struct svalue r0 = sv_view(r, 2 * k), rinf = sv_view(r + 4 * k, rn - 4 * k);
+
+    sv_add(r3, r3, r1, -1);
+    sv_divexact_3(r3);
+    sv_add(r1, r1, rm1, -1);
+    sv_shr1(r1);
+    sv_add(r2, rm1, &r0, -1);
+    sv_add(r3, r2, r3, -1);
+    sv_shr1(r3);
+    sv_add(r3, r3, &rinf, 1);
+    sv_add(r3, r3, &rinf, 1);
+    sv_add(r2, r2, r1, 1);
+    sv_add(r2, r2, &rinf, -1);
+    sv_add(r1, r1, r3, -1);
+
+    memset(r + 2 * k, 0, sizeof(limb_t) * 2 * k);
+    add_at(r, rn, k, r1->limbs, r1->size);
+    add_at(r, rn, 2 * k, r2->limbs, r2->size);
+    add_at(r, rn, 3 * k, r3->limbs, r3->size);
+    scratch_free(scratch);
+    return SUCCESS;
+}
+
+//r = a^2, r has 2n limbs and must not overlap a
+int8_t limbs_sqr(limb_t *r, const limb_t *a, size_t n) {
+    if (n < threshold_values[THRESHOLD_SQR_KARATSUBA]) {
+        STAT_TIER_BEGIN(STAT_SQR_BASECASE);
+        limbs_sqr_basecase(r, a, n);
+        STAT_TIER_END(STAT_SQR_BASECASE);
+        return SUCCESS;
+    }
+    if (n >= threshold_values[THRESHOLD_SQR_NTT]) return STAT_TIMED(STAT_SQR_NTT, limbs_mul_ntt(r, a, n, a, n));
+    if (n < threshold_values[THRESHOLD_SQR_TOOM3] || n <= 2 * ((n + 2) / 3)) {
+        return STAT_TIMED(STAT_SQR_KARATSUBA, sqr_karatsuba(r, a, n));
+    }
+    return STAT_TIMED(STAT_SQR_TOOM3, mul_toom3(r, a, n, a, n));
+}
+
+//r = a * b, r has an + bn limbs and must not overlap a or b; a == b with an == bn squares
+int8_t limbs_mul(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    if (a == b && an == bn) return limbs_sqr(r, a, an);
+    if (an < bn) {
+        swap(const limb_t *, a, b);
+        swap(size_t, an, bn);
+    }
+    if (bn < threshold_values[THRESHOLD_MUL_KARATSUBA]) {
+        STAT_TIER_BEGIN(STAT_MUL_BASECASE);
+        limbs_mul_basecase(r, a, an, b, bn);
+        STAT_TIER_END(STAT_MUL_BASECASE);
+        return SUCCESS;
+    }
+    if (bn >= threshold_values[THRESHOLD_MUL_NTT]) return STAT_TIMED(STAT_MUL_NTT, limbs_mul_ntt(r, a, an, b, bn));
+    if (bn <= (an + 1) / 2) return STAT_TIMED(STAT_MUL_UNBALANCED, mul_unbalanced(r, a, an, b, bn));
+    if (bn < threshold_values[THRESHOLD_MUL_TOOM3] || bn <= 2 * ((an + 2) / 3)) {
+        return STAT_TIMED(STAT_MUL_KARATSUBA, mul_karatsuba(r, a, an, b, bn));
+    }
+    return STAT_TIMED(STAT_MUL_TOOM3, mul_toom3(r, a, an, b, bn));
+}
+
+/*
+  Signed accumulators: r holds |acc| in rn limbs with the sign apart, as in a BigNum, and is widened by one limb
+  above the larger of acc and the term. A difference is computed modulo B^k over those k limbs; since both sides
+  are below B^(k - 1), a negative one shows up as a set top limb and is negated back.
+*/
+static void acc_finish(limb_t *r, size_t k, size_t *rn, int *r_sign) {
+    if (r[k - 1] >> (LIMB_BITS - 1)) {
+        for (size_t i = 0; i < k; i++) {
+            r[i] = ~r[i];
+        }
+        limbs_add_1(r, r, k, 1);
+        *r_sign = -*r_sign;
+    }
+    *rn = limbs_normalized_size(r, k);
+    if (*rn == 1 && r[0] == 0) *r_sign = 1;
+}
+
+//acc += sign * a, r has room for max(rn, an) + 1 limbs and must not overlap a
+void limbs_acc_add(limb_t *r, size_t *rn, int *r_sign, const limb_t *a, size_t an, int sign) {
+    size_t k = (*rn > an ? *rn : an) + 1;
+    memset(r + *rn, 0, sizeof(limb_t) * (k - *rn));
+    if (sign == *r_sign) {
+        limbs_add(r, r, k, a, an);
+    } else {
+        limbs_sub(r, r, k, a, an);
+    }
+    acc_finish(r, k, rn, r_sign);
+}
+
+/*
+  acc += sign * a * b, r has room for max(rn, an + bn) + 1 limbs and must not overlap a or b.
+  Below the Karatsuba threshold the rows of the product go straight into acc through addmul_1 or submul_1,
+  larger products are formed in tmp of an + bn limbs, or in scratch if tmp is NULL, and added.
+*/
+int8_t limbs_acc_addmul(limb_t *r, size_t *rn, int *r_sign, const limb_t *a, size_t an, const limb_t *b, size_t bn,
+                        int sign, limb_t *tmp) {
+    if (an < bn) {
+        swap(const limb_t*, a, b);
+        swap(size_t, an, bn);
+    }
+    if (bn >= threshold_values[THRESHOLD_MUL_KARATSUBA]) {
+        limb_t *p = tmp != NULL ? tmp : (limb_t *) scratch_alloc(sizeof(limb_t) * (an + bn));
+        if (p == NULL) return ERROR;
+        int8_t code = limbs_mul(p, a, an, b, bn);
+        if (code == SUCCESS) limbs_acc_add(r, rn, r_sign, p, limbs_normalized_size(p, an + bn), sign);
+        if (p != tmp) scratch_free(p);
+        return code;
+    }
+    STAT_TIER_BEGIN(STAT_MUL_BASECASE);
+    if (*rn == 1 && r[0] == 0) {
+        //the first term of a sum
+        limbs_mul_basecase(r, a, an, b, bn);
+        *rn = limbs_normalized_size(r, an + bn);
+        *r_sign = *rn == 1 && r[0] == 0 ? 1 : sign;
+        STAT_TIER_END(STAT_MUL_BASECASE);
+        return SUCCESS;
+    }
+    size_t k = (*rn > an + bn ? *rn : an + bn) + 1;
+    memset(r + *rn, 0, sizeof(limb_t) * (k - *rn));
+    //the carry of a row lands on the limb above it, which passes it on only if it wraps
+    if (sign == *r_sign) {
+        for (size_t i = 0; i < bn; i++) {
+            limb_t *top = r + i + an, carry = limbs_addmul_1(r + i, a, an, b[i]);
+            *top += carry;
+            if (*top < carry) limbs_add_1(top + 1, top + 1, k - i - an - 1, 1);
+        }
+    } else {
+        for (size_t i = 0; i < bn; i++) {
+            limb_t *top = r + i + an, borrow = limbs_submul_1(r + i, a, an, b[i]);
+            limb_t old = *top;
+            *top -= borrow;
+            if (old < borrow) limbs_sub_1(top + 1, top + 1, k - i - an - 1, 1);
+        }
+    }
+    STAT_TIER_END(STAT_MUL_BASECASE);
+    acc_finish(r, k, rn, r_sign);
+    return SUCCESS;
+}
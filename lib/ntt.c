@@ -0,0 +1,332 @@
+#include "limbs.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  Number-theoretic transform over three primes p = c * 2^40 + 1 < 2^63.
+  Every limb is one coefficient, so a coefficient of the product is below min(an, bn) * 2^128,
+  which the product of the primes (about 2^189) covers for any operand that fits into memory.
+  The exact coefficients are recovered with Garner's CRT.
+*/
+
+#define NTT_PRIMES 3
+#define NTT_MAX_LOG 40
+
+static const limb_t ntt_primes[NTT_PRIMES] = {0x7ffffe0000000001ull, 0x7fffef0000000001ull, 0x7fffe90000000001ull};
+static const limb_t ntt_generators[NTT_PRIMES] = {7, 5, 7};
+
+//Montgomery arithmetic modulo p with R = 2^64, values are kept fully reduced
+struct mont {
+    limb_t p;
+    limb_t pinv; // -p^-1 mod R
+    limb_t r2; // R^2 mod p
+};
+
+static limb_t mul_mod(limb_t a, limb_t b, limb_t p) {
+    return (limb_t) ((dlimb_t) a * b % p);
+}
+
+static limb_t pow_mod(limb_t a, limb_t e, limb_t p) {
+    limb_t res = 1;
+    for (; e != 0; e >>= 1) {
+        if (e & 1) res = mul_mod(res, a, p);
+        a = mul_mod(a, a, p);
+    }
+    return res;
+}
+
+static void mont_init(struct mont *m, limb_t p) {
+    limb_t inv = p;
+    for (int i = 0; i < 6; i++) {
+        inv *= 2 - p * inv;
+    }
+    m->p = p;
+    m->pinv = -inv;
+    limb_t r = (limb_t) ((((dlimb_t) 1) << LIMB_BITS) % p);
+    m->r2 = mul_mod(r, r, p);
+}
+
+static inline limb_t mont_mul(limb_t a, limb_t b, const struct mont *m) {
+    dlimb_t t = (dlimb_t) a * b;
+    limb_t q = (limb_t) t * m->pinv;
+    limb_t u = (limb_t) ((t + (dlimb_t) q * m->p) >> LIMB_BITS);
+    return u >= m->p ? u - m->p : u;
+}
+
+static inline limb_t add_mod(limb_t a, limb_t b, limb_t p) {
+    limb_t s = a + b;
+    return s >= p ? s - p : s;
+}
+
+static inline limb_t sub_mod(limb_t a, limb_t b, limb_t p) {
+    return a >= b ? a - b : a + p - b;
+}
+
+/*
+  Every loop of a transform is a body over a range of indices, so that a pool can split it.
+  A stage of butterflies is split over the butterflies, whatever the number of blocks it has.
+*/
+#define NTT_CHUNK 1024 //butterflies or coefficients a thread takes at least
+
+struct transform {
+    struct mont m;
+    size_t len;
+    limb_t *res, *tmp; //tmp is NULL for a square
+    limb_t *roots;
+    limb_t w; //root of the roots being filled
+    const limb_t *src; //operand being loaded into dst
+    limb_t *dst;
+    size_t n;
+    size_t half, stride; //current stage
+    unsigned shift; //log2 of half
+    limb_t scale;
+};
+
+static void run_range(struct transform *t, bool parallel, size_t count,
+                      int8_t (*body)(void *ctx, size_t begin, size_t end)) {
+    //the bodies cannot fail
+    if (parallel) {
+        parallel_for(count, NTT_CHUNK, body, t);
+    } else {
+        body(t, 0, count);
+    }
+}
+
+//roots[j] = w^j in Montgomery form for j < len / 2, w being a primitive len-th root of unity
+static int8_t fill_roots(void *ctx, size_t begin, size_t end) {
+    struct transform *t = (struct transform *) ctx;
+    limb_t w_mont = mont_mul(t->w, t->m.r2, &t->m);
+    t->roots[begin] = mont_mul(pow_mod(t->w, begin, t->m.p), t->m.r2, &t->m);
+    for (size_t j = begin + 1; j < end; j++) {
+        t->roots[j] = mont_mul(t->roots[j - 1], w_mont, &t->m);
+    }
+    return SUCCESS;
+}
+
+static int8_t load_residues(void *ctx, size_t begin, size_t end) {
+    struct transform *t = (struct transform *) ctx;
+    limb_t p = t->m.p;
+    for (size_t i = begin; i < end; i++) {
+        limb_t x = i < t->n ? t->src[i] : 0;
+        while (x >= p) x -= p;
+        t->dst[i] = x;
+    }
+    return SUCCESS;
+}
+
+//decimation in frequency butterflies of one stage
+static int8_t forward_butterflies(void *ctx, size_t begin, size_t end) {
+    struct transform *t = (struct transform *) ctx;
+    size_t half = t->half, stride = t->stride;
+    while (begin < end) {
+        size_t j = begin & (half - 1), stop = j + (end - begin) < half ? j + (end - begin) : half;
+        limb_t *x = t->dst + ((begin >> t->shift) << (t->shift + 1)), *y = x + half;
+        begin += stop - j;
+        for (; j < stop; j++) {
+            limb_t u = x[j], v = y[j];
+            x[j] = add_mod(u, v, t->m.p);
+            y[j] = mont_mul(sub_mod(u, v, t->m.p), t->roots[j * stride], &t->m);
+        }
+    }
+    return SUCCESS;
+}
+
+//decimation in time butterflies of one stage
+static int8_t inverse_butterflies(void *ctx, size_t begin, size_t end) {
+    struct transform *t = (struct transform *) ctx;
+    size_t half = t->half, stride = t->stride;
+    while (begin < end) {
+        size_t j = begin & (half - 1), stop = j + (end - begin) < half ? j + (end - begin) : half;
+        limb_t *x = t->dst + ((begin >> t->shift) << (t->shift + 1)), *y = x + half;
+        begin += stop - j;
+        for (; j < stop; j++) {
+            limb_t u = x[j], v = mont_mul(y[j], t->roots[j * stride], &t->m);
+            x[j] = add_mod(u, v, t->m.p);
+            y[j] = sub_mod(u, v, t->m.p);
+        }
+    }
+    return SUCCESS;
+}
+
+//natural order in, bit-reversed order out
+static void ntt_forward(struct transform *t, limb_t *a, bool parallel) {
+    t->dst = a;
+    t->shift = 0;
+    while ((size_t) 2 << t->shift < t->len) t->shift++;
+    for (t->half = t->len / 2, t->stride = 1; t->half > 0; t->half >>= 1, t->stride <<= 1, t->shift--) {
+        run_range(t, parallel, t->len / 2, forward_butterflies);
+    }
+}
+
+//bit-reversed order in, natural order out, the roots have to be inverse ones and the result is not scaled
+static void ntt_inverse(struct transform *t, limb_t *a, bool parallel) {
+    t->dst = a;
+    t->shift = 0;
+    for (t->half = 1, t->stride = t->len / 2; t->half < t->len; t->half <<= 1, t->stride >>= 1, t->shift++) {
+        run_range(t, parallel, t->len / 2, inverse_butterflies);
+    }
+}
+
+static int8_t pointwise(void *ctx, size_t begin, size_t end) {
+    struct transform *t = (struct transform *) ctx;
+    const limb_t *other = t->tmp != NULL ? t->tmp : t->res;
+    for (size_t i = begin; i < end; i++) {
+        t->res[i] = mont_mul(t->res[i], other[i], &t->m);
+    }
+    return SUCCESS;
+}
+
+static int8_t scale(void *ctx, size_t begin, size_t end) {
+    struct transform *t = (struct transform *) ctx;
+    for (size_t i = begin; i < end; i++) {
+        t->res[i] = mont_mul(t->res[i], t->scale, &t->m);
+    }
+    return SUCCESS;
+}
+
+//res = a * b mod the prime, res and tmp have len limbs, b == NULL requests a square
+static void ntt_mul_prime(limb_t *res, limb_t *tmp, limb_t *roots, size_t len, int prime,
+                          const limb_t *a, size_t an, const limb_t *b, size_t bn, bool parallel) {
+    struct transform t;
+    limb_t p = ntt_primes[prime];
+    mont_init(&t.m, p);
+    t.len = len;
+    t.res = res;
+    t.tmp = b != NULL ? tmp : NULL;
+    t.roots = roots;
+    t.w = pow_mod(ntt_generators[prime], (p - 1) / len, p);
+
+    run_range(&t, parallel, len / 2, fill_roots);
+    t.src = a;
+    t.n = an;
+    t.dst = res;
+    run_range(&t, parallel, len, load_residues);
+    ntt_forward(&t, res, parallel);
+    if (b != NULL) {
+        t.src = b;
+        t.n = bn;
+        t.dst = tmp;
+        run_range(&t, parallel, len, load_residues);
+        ntt_forward(&t, tmp, parallel);
+    }
+    run_range(&t, parallel, len, pointwise);
+
+    t.w = pow_mod(t.w, p - 2, p);
+    run_range(&t, parallel, len / 2, fill_roots);
+    ntt_inverse(&t, res, parallel);
+    //the pointwise product left a factor R^-1 behind, the scale below removes it together with len
+    t.scale = mul_mod(t.m.r2, pow_mod(len % p, p - 2, p), p);
+    run_range(&t, parallel, len, scale);
+}
+
+struct prime_task {
+    limb_t *res, *tmp, *roots;
+    size_t len;
+    int prime;
+    const limb_t *a;
+    size_t an;
+    const limb_t *b;
+    size_t bn;
+    bool parallel;
+};
+
+static int8_t run_prime(void *arg) {
+    struct prime_task *t = (struct prime_task *) arg;
+    ntt_mul_prime(t->res, t->tmp, t->roots, t->len, t->prime, t->a, t->an, t->b, t->bn, t->parallel);
+    return SUCCESS;
+}
+
+//Garner's constants, inverses in Montgomery form, so that one mont_mul multiplies by the plain inverse
+struct crt {
+    struct mont m1, m2;
+    limb_t inv01, inv02, inv12;
+    limb_t *const *residues;
+};
+
+//coefficient i becomes x0 + x1 * B + x2 * B^2, stored over the residues of the three primes
+static int8_t crt_coefficients(void *ctx, size_t begin, size_t end) {
+    struct crt *c = (struct crt *) ctx;
+    limb_t p0 = ntt_primes[0], p1 = ntt_primes[1], p2 = ntt_primes[2];
+    limb_t *x0 = c->residues[0], *x1 = c->residues[1], *x2 = c->residues[2];
+    for (size_t i = begin; i < end; i++) {
+        limb_t v0 = x0[i];
+        //p0 > p1 > p2 and p0 < 2 * p2, so one subtraction reduces a residue modulo a smaller prime
+        limb_t v1 = mont_mul(sub_mod(x1[i], v0 >= p1 ? v0 - p1 : v0, p1), c->inv01, &c->m1);
+        limb_t v2 = mont_mul(sub_mod(x2[i], v0 >= p2 ? v0 - p2 : v0, p2), c->inv02, &c->m2);
+        v2 = mont_mul(sub_mod(v2, v1 >= p2 ? v1 - p2 : v1, p2), c->inv12, &c->m2);
+        //x = v0 + p0 * (v1 + p1 * v2)
+        dlimb_t t = (dlimb_t) p1 * v2 + v1;
+        dlimb_t lo = (dlimb_t) p0 * (limb_t) t + v0;
+        dlimb_t hi = (dlimb_t) p0 * (limb_t) (t >> LIMB_BITS) + (limb_t) (lo >> LIMB_BITS);
+        x0[i] = (limb_t) lo;
+        x1[i] = (limb_t) hi;
+        x2[i] = (limb_t) (hi >> LIMB_BITS);
+    }
+    return SUCCESS;
+}
+
+//r = sum of coefficients[i] * B^i, count + 1 limbs, the residues come from the three primes and get overwritten
+static void crt_combine(limb_t *r, limb_t *const residues[NTT_PRIMES], size_t count, bool parallel) {
+    limb_t p0 = ntt_primes[0], p1 = ntt_primes[1], p2 = ntt_primes[2];
+    struct crt c;
+    mont_init(&c.m1, p1);
+    mont_init(&c.m2, p2);
+    c.inv01 = mul_mod(pow_mod(p0 % p1, p1 - 2, p1), (limb_t) ((((dlimb_t) 1) << LIMB_BITS) % p1), p1);
+    c.inv02 = mul_mod(pow_mod(p0 % p2, p2 - 2, p2), (limb_t) ((((dlimb_t) 1) << LIMB_BITS) % p2), p2);
+    c.inv12 = mul_mod(pow_mod(p1 % p2, p2 - 2, p2), (limb_t) ((((dlimb_t) 1) << LIMB_BITS) % p2), p2);
+    c.residues = residues;
+    if (parallel) {
+        parallel_for(count, NTT_CHUNK, crt_coefficients, &c);
+    } else {
+        crt_coefficients(&c, 0, count);
+    }
+
+    //the product has count + 1 limbs, so the top limbs of the shifted rows and every carry out are zero
+    memcpy(r, residues[0], sizeof(limb_t) * count);
+    r[count] = 0;
+    limbs_add_n(r + 1, r + 1, residues[1], count);
+    limbs_add_n(r + 2, r + 2, residues[2], count - 1);
+}
+
+/*
+  r = a * b through the transform, r has an + bn limbs, a == b with an == bn transforms the operand once.
+  On a pool the primes are transformed at once, each with its own roots, and every loop is split further.
+*/
+int8_t limbs_mul_ntt(limb_t *r, const limb_t *a, size_t an, const limb_t *b, size_t bn) {
+    size_t count = an + bn - 1;
+    size_t len = 2;
+    int log = 1;
+    while (len < count) {
+        len <<= 1;
+        log++;
+    }
+    if (log > NTT_MAX_LOG) return ERROR;
+    bool square = a == b && an == bn;
+    bool parallel = parallel_worth(an < bn ? an : bn);
+
+    //residues, then roots and tmp, one set for every prime if they run in parallel
+    size_t work = len / 2 + (square ? 0 : len);
+    size_t sets = parallel ? NTT_PRIMES : 1;
+    limb_t *scratch = (limb_t *) scratch_alloc(sizeof(limb_t) * (NTT_PRIMES * len + sets * work));
+    if (scratch == NULL) return ERROR;
+    limb_t *residues[NTT_PRIMES];
+    struct prime_task args[NTT_PRIMES];
+    struct task tasks[NTT_PRIMES];
+    for (int i = 0; i < NTT_PRIMES; i++) {
+        residues[i] = scratch + i * len;
+        limb_t *roots = scratch + NTT_PRIMES * len + (parallel ? i * work : 0);
+        args[i] = (struct prime_task) {residues[i], square ? NULL : roots + len / 2, roots, len, i, a, an,
+                                       square ? NULL : b, bn, parallel};
+        tasks[i] = (struct task) {run_prime, &args[i], SUCCESS};
+    }
+    if (parallel) {
+        parallel_run(tasks, NTT_PRIMES);
+    } else {
+        for (int i = 0; i < NTT_PRIMES; i++) {
+            run_prime(&args[i]);
+        }
+    }
+    crt_combine(r, residues, count, parallel);
+    scratch_free(scratch);
+    return SUCCESS;
+}
@@ -1,9 +1,9 @@
 #include "number.h"
+#include "limbs.h"
+#include "stats.h"
 #include <stdlib.h>
-#include <ctype.h>
 #include <string.h>
 
-const int base = 10;
 #define swap(T, x, y) \
     {                 \
         T obj = (x);  \
@@ -11,22 +11,99 @@ const int base = 10;
         (y) = obj;    \
     }
 
+static bool is_inline(BigNum num) {
+    return num->limbs_ == num->inline_;
+}
+
+//views of foreign memory have no capacity, they are copied before the first write
+static bool owns_storage(BigNum num) {
+    return num->capacity_ != 0 && !is_inline(num);
+}
+
+void num_release_storage(BigNum num) {
+    if (owns_storage(num)) num_free(num->limbs_);
+    num->limbs_ = num->inline_;
+    num->capacity_ = NUM_INLINE_LIMBS;
+    num->size_ = 0;
+}
+
 void SwapNums(BigNum lhs, BigNum rhs) {
     swap(size_t, lhs->size_, rhs->size_);
-    swap(char*, lhs->digits_, rhs->digits_);
+    swap(limb_t*, lhs->limbs_, rhs->limbs_);
+    swap(size_t, lhs->capacity_, rhs->capacity_);
     swap(int, lhs->sign_, rhs->sign_);
+    for (int i = 0; i < NUM_INLINE_LIMBS; i++) {
+        swap(limb_t, lhs->inline_[i], rhs->inline_[i]);
+    }
+    //inline storage stays with its struct, only the pointers to it have to follow
+    if (lhs->limbs_ == rhs->inline_) lhs->limbs_ = lhs->inline_;
+    if (rhs->limbs_ == lhs->inline_) rhs->limbs_ = rhs->inline_;
 }
 
-BigNum CreateNum() {
-    BigNum tmp = (BigNum) (malloc(sizeof(struct BigNum)));
+BigNum CreateNumIn(NumCtx ctx) {
+    STAT_CALL(STAT_CREATE, 0);
+    BigNum tmp = (BigNum) num_alloc(ctx, sizeof(struct BigNum));
     if (tmp != NULL) {
-        tmp->digits_ = NULL;
+        tmp->limbs_ = tmp->inline_;
         tmp->size_ = 0;
+        tmp->capacity_ = NUM_INLINE_LIMBS;
         tmp->sign_ = 0;
+        tmp->ctx_ = ctx;
     }
     return tmp;
 }
 
+BigNum CreateNum() {
+    return CreateNumIn(GetThreadCtx());
+}
+
+bool num_is_zero(BigNum num) {
+    return num->size_ == 0 || (num->size_ == 1 && num->limbs_[0] == 0);
+}
+
+BigNum num_or_zero(BigNum num, struct BigNum *zero) {
+    if (num->size_ != 0) return num;
+    zero->limbs_ = zero->inline_;
+    zero->inline_[0] = 0;
+    zero->size_ = 1;
+    zero->capacity_ = NUM_INLINE_LIMBS;
+    zero->sign_ = 1;
+    zero->ctx_ = NULL;
+    return zero;
+}
+
+//shrinks size_ to the significant limbs, zero is always positive
+static void normalize(BigNum num) {
+    num->size_ = limbs_normalized_size(num->limbs_, num->size_);
+    if (num->size_ == 1 && num->limbs_[0] == 0) num->sign_ = 1;
+}
+
+//grows the storage to at least size limbs, the first size_ limbs survive only if keep is set
+static int8_t reserve(BigNum num, size_t size, bool keep) {
+    if (size <= num->capacity_) return SUCCESS;
+    limb_t *limbs;
+    if (!owns_storage(num)) {
+        //a view may be longer than the requested size, its value has to survive in full
+        if (keep && num->size_ > size) size = num->size_;
+        limbs = (limb_t *) num_alloc(num->ctx_, sizeof(limb_t) * size);
+        if (limbs != NULL && keep && num->size_ != 0) memcpy(limbs, num->limbs_, sizeof(limb_t) * num->size_);
+    } else if (keep) {
+        limbs = (limb_t *) num_realloc(num->ctx_, num->limbs_, sizeof(limb_t) * size);
+    } else {
+        limbs = (limb_t *) num_alloc(num->ctx_, sizeof(limb_t) * size);
+        if (limbs != NULL) num_free(num->limbs_);
+    }
+    if (limbs == NULL) return ERROR;
+    num->limbs_ = limbs;
+    num->capacity_ = size;
+    return SUCCESS;
+}
+
+int8_t ReserveNum(BigNum num, size_t limbs) {
+    if (num == NULL) return ERROR;
+    return reserve(num, limbs, true);
+}
+
 //gets non-empty null-terminated string
 static int first_non_null(const char *str, size_t len) {
     bool has_a_sign = (str[0] == '-' || str[0] == '+');
@@ -38,352 +115,402 @@ static int first_non_null(const char *str, size_t len) {
 }
 
 //target must be a result of CreateNum()
-static int8_t set_from_str_with_size(char const *str, size_t str_size, BigNum target) {
-    if (str == NULL || target == NULL || strcmp(str, "") == 0) return ERROR;
+static int8_t set_from_str_with_size(char const *str, size_t str_size, BigNum target, int base) {
+    if (str == NULL || target == NULL || str_size == 0 || base < 2 || base > 36) return ERROR;
     int first_non_null_digit = first_non_null(str, str_size);
     if (first_non_null_digit >= str_size) return ERROR;
-    free(target->digits_); // if target is already initialised;
-
-    target->size_ = str_size - first_non_null_digit;
-
-    target->digits_ = (char *) malloc(sizeof(char) * target->size_);
-
-    if (target->digits_ == NULL) return ERROR;
-
-    int ind = str_size - 1;
-    for (size_t dig_ind = 0; ind >= first_non_null_digit; ind--) {
-        if (!isdigit(str[ind])) return ERROR;
-        target->digits_[dig_ind++] = str[ind] - '0';
-    }
-
-    if (isdigit(str[0])) {
-        target->sign_ = 1;
+    int sign;
+    if (limbs_digit_value(str[0]) < base) {
+        sign = 1;
     } else if (str[0] == '+' || str[0] == '-') {
-        target->sign_ = str[0] == '+' || target->digits_[target->size_ - 1] == 0 ? 1 : -1;
+        sign = str[0] == '+' ? 1 : -1;
     } else return ERROR;
-
+    for (size_t ind = first_non_null_digit; ind < str_size; ind++) {
+        if (limbs_digit_value(str[ind]) >= base) return ERROR;
+    }
+
+    size_t digits = str_size - first_non_null_digit;
+    STAT_CALL(STAT_SET_STR, limbs_size_for_digits(digits, base));
+    //the old value is of no use, and a failed conversion must not leave its size over limbs it no longer has
+    target->size_ = 0;
+    if (reserve(target, limbs_size_for_digits(digits, base), false) == ERROR) return ERROR;
+    size_t size;
+    if (limbs_from_str(target->limbs_, &size, str + first_non_null_digit, digits, base) == ERROR) return ERROR;
+    if (size == 0) target->limbs_[size++] = 0;
+
+    target->size_ = size;
+    target->sign_ = sign;
+    normalize(target);
     return SUCCESS;
 }
 
 //undefined behaviour if str is not a null terminated string
 int8_t SetFromStr(BigNum target, char const *str) {
-    return set_from_str_with_size(str, strlen(str), target);
+    return set_from_str_with_size(str, strlen(str), target, 10);
 }
 
-//null if couldn't alloc , ub if num was initialised incorrectly
-char *ToStr(BigNum num) {
-    bool is_negative = num->sign_ == -1;
-    int additional_cells = (is_negative ? 2 : 1);
-    char *str = (char *) malloc(sizeof(char) * (num->size_ + additional_cells));
-    if (str == NULL) return str;
-    if (is_negative) str[0] = '-';
-
-    for (size_t i = 0; i < num->size_; i++) {
-        str[i + is_negative] = num->digits_[num->size_ - 1 - i] + '0';
-    }
+int8_t SetFromStrBase(BigNum target, char const *str, int base) {
+    return set_from_str_with_size(str, strlen(str), target, base);
+}
 
-    str[num->size_ + is_negative] = '\0';
-    return str;
+int8_t SetFromBuf(BigNum target, char const *buf, size_t len) {
+    return set_from_str_with_size(buf, len, target, 10);
 }
 
-static char minus(char l, char r, char *overhead) {
-    bool need_additional = (l - *overhead) < r;
-    char additional = need_additional ? base : 0;
-    char result = l + additional - r - *overhead;
-    *overhead = need_additional ? 1 : 0;
-    return result;
+struct buffer_sink {
+    struct digit_sink sink;
+    char *out;
+    size_t len;
+    size_t cap;
+};
+
+static int8_t buffer_write(struct digit_sink *sink, const char *digits, size_t len) {
+    struct buffer_sink *buffer = (struct buffer_sink *) sink;
+    if (len > buffer->cap - buffer->len) return ERROR;
+    memcpy(buffer->out + buffer->len, digits, len);
+    buffer->len += len;
+    return SUCCESS;
 }
 
-static int8_t rearrange_minus(BigNum tmp, char overhead) {
-    size_t i = tmp->size_ - 1;
-    while (i > 0 && tmp->digits_[i] == 0) {
-        i--;
-    }
-    tmp->size_ = i + 1;
-    char *insurance = tmp->digits_;
-    tmp->digits_ = (char *) realloc(tmp->digits_, sizeof(char *) * tmp->size_);
-    if (tmp->digits_ == NULL) {
-        free(insurance);
-        return ERROR;
-    }
+static int8_t to_buffer(BigNum num, char *out, size_t cap, size_t *len, int base) {
+    STAT_CALL(STAT_TO_STR, num->size_);
+    struct buffer_sink buffer = {{buffer_write}, out, 0, cap};
+    if (num->sign_ == -1 && buffer_write(&buffer.sink, "-", 1) == ERROR) return ERROR;
+    if (limbs_to_str(&buffer.sink, num->limbs_, num->size_, base) == ERROR) return ERROR;
+    *len = buffer.len;
     return SUCCESS;
 }
 
-static void set_sign_minus(BigNum tmp, int lhs) {
-    if (lhs == -1 &&
-        !(tmp->size_ == 1 &&
-          tmp->digits_[0] == 0)) { //-> rhs.sign = +1 cause set_sign_minus is used when signs are different
-        tmp->sign_ = -1;
-    } else {
-        tmp->sign_ = +1;
-    }
+//null if couldn't alloc , ub if num was initialised incorrectly
+char *ToStrBase(BigNum num, int base) {
+    if (base < 2 || base > 36) return NULL;
+    size_t cap = limbs_digits_bound(num->size_, base) + 1;
+    char *str = (char *) malloc(sizeof(char) * (cap + 1));
+    size_t len;
+    if (str == NULL || to_buffer(num, str, cap, &len, base) == ERROR) {
+        free(str);
+        return NULL;
+    }
+    str[len] = '\0';
+    return str;
 }
 
-static char plus(char l, char r, char *overhead) {
-    char intermediate = l + r + *overhead;
-    *overhead = intermediate / base;
-    return intermediate % base;
+char *ToStr(BigNum num) {
+    return ToStrBase(num, 10);
 }
 
-static int8_t rearrange_plus(BigNum tmp, char overhead) {
-    char *insurance = NULL;
-    if (overhead != 0) {
-        tmp->size_ += 1;
-        insurance = tmp->digits_;
-        tmp->digits_ = (char *) realloc(tmp->digits_, sizeof(char) * tmp->size_);
-        if (tmp->digits_ == NULL) {
-            free(insurance);
-            return ERROR;
-        }
-        tmp->digits_[tmp->size_ - 1] = overhead;
-    }
-    return SUCCESS;
+int8_t ToBuf(BigNum num, char *out, size_t cap, size_t *len) {
+    if (num == NULL || out == NULL || len == NULL) return ERROR;
+    return to_buffer(num, out, cap, len, 10);
 }
 
-static void set_sign_plus(BigNum tmp, int lhs) {
-    tmp->sign_ = lhs;
+//single-limb operands, res has room for the two result limbs
+static void add_words(limb_t a, int a_sign, limb_t b, int b_sign, BigNum res) {
+    if (a_sign == b_sign) {
+        limb_t sum = a + b;
+        res->limbs_[0] = sum;
+        res->limbs_[1] = sum < a;
+        res->size_ = 1 + (sum < a);
+        res->sign_ = a_sign;
+        return;
+    }
+    res->limbs_[0] = a >= b ? a - b : b - a;
+    res->size_ = 1;
+    res->sign_ = a == b ? 1 : (a > b ? a_sign : b_sign);
 }
 
-static int8_t
-apply_operation(BigNum lhs, BigNum rhs, BigNum tmp, char(*operation)(char, char, char *),
-                int8_t(*rearrange)(BigNum, char), void(*set_sign)(BigNum, int), int sign_lhs) {
-    char overhead = 0;
-    for (size_t i = 0; i < rhs->size_; i++) {
-        tmp->digits_[i] = operation(lhs->digits_[i], rhs->digits_[i], &overhead);
-    }
-    for (size_t i = rhs->size_; i < lhs->size_; i++) {
-        tmp->digits_[i] = operation(lhs->digits_[i], 0, &overhead);
+//res = lhs + rhs_sign * |rhs|, res may be lhs or rhs
+static int8_t add_signed(BigNum lhs, BigNum rhs, int rhs_sign, BigNum res) {
+    if (lhs == NULL || rhs == NULL || res == NULL) return ERROR;
+    STAT_CALL(STAT_ADD, lhs->size_ > rhs->size_ ? lhs->size_ : rhs->size_);
+    if (lhs->size_ == 1 && rhs->size_ == 1 && res->capacity_ >= NUM_INLINE_LIMBS) {
+        add_words(lhs->limbs_[0], lhs->sign_, rhs->limbs_[0], rhs_sign, res);
+        return SUCCESS;
     }
-    int8_t code = rearrange(tmp, overhead);
-    if (code == SUCCESS) {
-        set_sign(tmp, sign_lhs);
+    bool lhs_bigger = limbs_cmp(lhs->limbs_, lhs->size_, rhs->limbs_, rhs->size_) != -1;
+    BigNum big = lhs_bigger ? lhs : rhs;
+    BigNum small = lhs_bigger ? rhs : lhs;
+    int sign = lhs_bigger ? lhs->sign_ : rhs_sign;
+    bool same_signs = lhs->sign_ == rhs_sign;
+    size_t big_size = big->size_, small_size = small->size_;
+
+    //limbwise kernels allow res to coincide with either operand, so nothing is copied
+    if (reserve(res, big_size + 1, res == big || res == small) == ERROR) return ERROR;
+    if (same_signs) {
+        res->limbs_[big_size] = limbs_add(res->limbs_, big->limbs_, big_size, small->limbs_, small_size);
+    } else {
+        limbs_sub(res->limbs_, big->limbs_, big_size, small->limbs_, small_size);
+        res->limbs_[big_size] = 0;
     }
-    return code;
+    res->size_ = big_size + 1;
+    res->sign_ = sign;
+    normalize(res);
+    return SUCCESS;
 }
 
-#define MAX(a, b) (((a)>(b))?(a):(b))
-
 //res must be a result of CreateNum, lhs and rhs must be initialized
 int8_t Add(BigNum lhs, BigNum rhs, BigNum res) {
-    BigNum lhs_abs = CreateNum();
-    BigNum rhs_abs = CreateNum();
-    if (lhs == NULL || rhs == NULL || Abs(lhs, lhs_abs) == ERROR || Abs(rhs, rhs_abs) == ERROR) {
-        FreeNum(lhs_abs);
-        FreeNum(rhs_abs);
-        return ERROR;
-    }
-    int8_t cmp = Compare(lhs_abs, rhs_abs);
-
-    BigNum tmp = CreateNum();
-    if (tmp == NULL) {
-        FreeNum(lhs_abs);
-        FreeNum(rhs_abs);
-        return ERROR;
-    }
-    tmp->size_ = MAX(lhs->size_, rhs->size_);
-    tmp->sign_ = 1;
-    tmp->digits_ = (char *) malloc(sizeof(char) * tmp->size_);
-    if (tmp->digits_ == NULL) {
-        FreeNum(tmp);
-        FreeNum(lhs_abs);
-        FreeNum(rhs_abs);
-        return ERROR;
-    }
+    if (rhs == NULL) return ERROR;
+    return add_signed(lhs, rhs, rhs->sign_, res);
+}
 
-    int8_t code;
-    if (lhs->sign_ == rhs->sign_) {
-        code = cmp != -1 ? apply_operation(lhs_abs, rhs_abs, tmp, plus, rearrange_plus, set_sign_plus, lhs->sign_)
-                         : apply_operation(rhs_abs, lhs_abs, tmp, plus, rearrange_plus, set_sign_plus, rhs->sign_);
-    } else {
-        code = cmp != -1 ? apply_operation(lhs_abs, rhs_abs, tmp, minus, rearrange_minus, set_sign_minus, lhs->sign_)
-                         : apply_operation(rhs_abs, lhs_abs, tmp, minus, rearrange_minus, set_sign_minus, rhs->sign_);
-    }
+int8_t Sub(BigNum lhs, BigNum rhs, BigNum res) {
+    if (rhs == NULL) return ERROR;
+    return add_signed(lhs, rhs, -rhs->sign_, res);
+}
 
-    if (code != ERROR) {
-        SwapNums(tmp, res);
-    }
+int8_t AddInPlace(BigNum acc, BigNum x) {
+    return Add(acc, x, acc);
+}
 
-    FreeNum(tmp);
-    FreeNum(lhs_abs);
-    FreeNum(rhs_abs);
-    return code;
+int8_t SubInPlace(BigNum acc, BigNum x) {
+    return Sub(acc, x, acc);
 }
 
-int8_t Sub(BigNum lhs, BigNum rhs, BigNum res) {
-    rhs->sign_ = -rhs->sign_;
-    int8_t code = Add(lhs, rhs, res);
-    if (rhs != res) rhs->sign_ = -rhs->sign_; // if Sub(lhs,rhs,rhs) was called
-    return code;
+static int8_t set_zero(BigNum num) {
+    if (reserve(num, 1, false) == ERROR) return ERROR;
+    num->limbs_[0] = 0;
+    num->size_ = 1;
+    num->sign_ = 1;
+    return SUCCESS;
 }
 
+//the product cannot overlap its operands, so only an aliased res gets a fresh buffer
 int8_t Mult(BigNum lhs, BigNum rhs, BigNum res) {
-    BigNum tmp;
-    tmp = CreateNum();
-    if (tmp == NULL) return ERROR;
-    tmp->digits_ = (char *) malloc(sizeof(char) * (lhs->size_ + rhs->size_));
-    if (tmp->digits_ == NULL) {
-        FreeNum(tmp);
+    if (lhs == NULL || rhs == NULL || res == NULL) return ERROR;
+    //also keeps numbers that were never set away from the limb routines
+    if (num_is_zero(lhs) || num_is_zero(rhs)) return set_zero(res);
+    if (lhs == rhs) return Sqr(lhs, res);
+    STAT_CALL(STAT_MULT, lhs->size_ > rhs->size_ ? lhs->size_ : rhs->size_);
+    if (lhs->size_ == 1 && rhs->size_ == 1 && res->capacity_ >= NUM_INLINE_LIMBS) {
+        dlimb_t product = (dlimb_t) lhs->limbs_[0] * rhs->limbs_[0];
+        res->sign_ = lhs->sign_ == rhs->sign_ ? +1 : -1;
+        res->limbs_[0] = (limb_t) product;
+        res->limbs_[1] = (limb_t) (product >> LIMB_BITS);
+        res->size_ = 2;
+        normalize(res);
+        return SUCCESS;
+    }
+    size_t size = lhs->size_ + rhs->size_;
+    bool aliased = res == lhs || res == rhs;
+    limb_t *limbs;
+    if (aliased) {
+        limbs = (limb_t *) num_alloc(res->ctx_, sizeof(limb_t) * size);
+        if (limbs == NULL) return ERROR;
+    } else {
+        if (reserve(res, size, false) == ERROR) return ERROR;
+        limbs = res->limbs_;
+    }
+    if (limbs_mul(limbs, lhs->limbs_, lhs->size_, rhs->limbs_, rhs->size_) == ERROR) {
+        if (aliased) num_free(limbs);
         return ERROR;
     }
-    for (int i = 0; i < lhs->size_ + rhs->size_; i++) {
-        tmp->digits_[i] = 0;
+    res->sign_ = lhs->sign_ == rhs->sign_ ? +1 : -1;
+    if (aliased) {
+        if (owns_storage(res)) num_free(res->limbs_);
+        res->limbs_ = limbs;
+        res->capacity_ = size;
     }
-    for (int i = 0; i < lhs->size_; i++) {
-        for (int j = 0, overhead = 0; j < rhs->size_ || overhead; j++) {
-            char intermediate =
-                    tmp->digits_[i + j] + lhs->digits_[i] * (j < rhs->size_ ? rhs->digits_[j] : 0) + overhead;
-            tmp->digits_[i + j] = intermediate % base;
-            overhead = intermediate / base;
-        }
+    res->size_ = size;
+    normalize(res);
+    return SUCCESS;
+}
+
+int8_t Sqr(BigNum x, BigNum res) {
+    if (x == NULL || res == NULL) return ERROR;
+    if (num_is_zero(x)) return set_zero(res);
+    STAT_CALL(STAT_SQR, x->size_);
+    if (x->size_ == 1 && res->capacity_ >= NUM_INLINE_LIMBS) {
+        dlimb_t square = (dlimb_t) x->limbs_[0] * x->limbs_[0];
+        res->sign_ = 1;
+        res->limbs_[0] = (limb_t) square;
+        res->limbs_[1] = (limb_t) (square >> LIMB_BITS);
+        res->size_ = 2;
+        normalize(res);
+        return SUCCESS;
+    }
+    size_t size = 2 * x->size_;
+    bool aliased = res == x;
+    limb_t *limbs;
+    if (aliased) {
+        limbs = (limb_t *) num_alloc(res->ctx_, sizeof(limb_t) * size);
+        if (limbs == NULL) return ERROR;
+    } else {
+        if (reserve(res, size, false) == ERROR) return ERROR;
+        limbs = res->limbs_;
+    }
+    if (limbs_sqr(limbs, x->limbs_, x->size_) == ERROR) {
+        if (aliased) num_free(limbs);
+        return ERROR;
+    }
+    res->sign_ = 1;
+    if (aliased) {
+        if (owns_storage(res)) num_free(res->limbs_);
+        res->limbs_ = limbs;
+        res->capacity_ = size;
     }
+    res->size_ = size;
+    normalize(res);
+    return SUCCESS;
+}
 
-    int ind = lhs->size_ + rhs->size_ - 1;
-    while (ind > 0 && tmp->digits_[ind] == 0) {
-        ind--;
+int8_t MultInPlace(BigNum acc, BigNum x) {
+    return Mult(acc, x, acc);
+}
+
+//acc = acc + sign * a * b for b of bn limbs, which may be the digits of acc
+static int8_t add_product(BigNum acc, BigNum a, const limb_t *b, size_t bn, int b_sign, int sign) {
+    if (acc == NULL || a == NULL) return ERROR;
+    size_t an = a->size_, rn = acc->size_;
+    //a zero product, never-set operands included, leaves acc as it is
+    if (num_is_zero(a) || bn == 0 || (bn == 1 && b[0] == 0)) return acc->size_ == 0 ? set_zero(acc) : SUCCESS;
+    STAT_CALL(STAT_ADD_MUL, an > bn ? an : bn);
+    int r_sign = acc->sign_;
+    if (rn == 0) {
+        acc->limbs_[0] = 0;
+        rn = 1;
+        r_sign = 1;
+    }
+    size_t size = (rn > an + bn ? rn : an + bn) + 1;
+    //the kernel writes over acc while it reads the operands
+    bool aliased = acc == a || acc->limbs_ == b;
+    limb_t *limbs;
+    if (aliased) {
+        limbs = (limb_t *) num_alloc(acc->ctx_, sizeof(limb_t) * size);
+        if (limbs == NULL) return ERROR;
+        memcpy(limbs, acc->limbs_, sizeof(limb_t) * rn);
+    } else {
+        acc->size_ = rn;
+        if (reserve(acc, size, true) == ERROR) return ERROR;
+        limbs = acc->limbs_;
     }
-    tmp->size_ = ind + 1;
-    char *insurance = tmp->digits_;
-    tmp->digits_ = (char *) (realloc(tmp->digits_, sizeof(char) * tmp->size_));
-    if (tmp->digits_ == NULL) {
-        free(insurance);
-        FreeNum(tmp);
+    if (limbs_acc_addmul(limbs, &rn, &r_sign, a->limbs_, an, b, bn, sign * a->sign_ * b_sign, NULL) == ERROR) {
+        if (aliased) num_free(limbs);
         return ERROR;
     }
-    tmp->sign_ = lhs->sign_ == rhs->sign_ ? +1 : -1;
-    SwapNums(tmp, res);
-    FreeNum(tmp);
+    if (aliased) {
+        if (owns_storage(acc)) num_free(acc->limbs_);
+        acc->limbs_ = limbs;
+        acc->capacity_ = size;
+    }
+    acc->size_ = rn;
+    acc->sign_ = r_sign;
     return SUCCESS;
 }
 
+int8_t AddMul(BigNum acc, BigNum a, BigNum b) {
+    if (b == NULL) return ERROR;
+    return add_product(acc, a, b->limbs_, b->size_, b->sign_, 1);
+}
+
+int8_t SubMul(BigNum acc, BigNum a, BigNum b) {
+    if (b == NULL) return ERROR;
+    return add_product(acc, a, b->limbs_, b->size_, b->sign_, -1);
+}
+
+int8_t AddMulUi(BigNum acc, BigNum a, uint64_t b) {
+    limb_t limb = b;
+    return add_product(acc, a, &limb, 1, 1, 1);
+}
+
+int8_t SubMulUi(BigNum acc, BigNum a, uint64_t b) {
+    limb_t limb = b;
+    return add_product(acc, a, &limb, 1, 1, -1);
+}
 
 int8_t Abs(BigNum from, BigNum to) {
-    BigNum tmp = CreateNum();
-    if (tmp == NULL) return ERROR;
-    if (CopyNum(from, tmp) == ERROR) {
-        FreeNum(tmp);
-        return ERROR;
-    };
-    tmp->sign_ = 1;
-    SwapNums(tmp, to);
-    FreeNum(tmp);
+    if (CopyNum(from, to) == ERROR) return ERROR;
+    to->sign_ = 1;
     return SUCCESS;
 }
 
 /*
   a / b:
   a = b * q + r    0 <= r < |b|
-  abs(lhs) >= abs(rhs):
-  ++ = default
-  -- = default -> q = q + 1   r = abs(rhs) - r
-  -+ = default -> q = -(q+1) r = abs(rhs) - r
-  +- = default -> q = -q    r = r
-
-  abs(lhs) <= abs(rhs)
-  ++ = default = q = 0 r = lhs
-  -- q = 1  r = abs(rhs) - abs(lhs)
-  -+ q = -1 r = abs(rhs) - abs(lhs)
-  +- q = 0 r = lhs
+  |a| = |b| * q0 + r0:
+  +a        -> q = sign(b) * q0          r = r0
+  -a, r0 = 0 -> q = -sign(b) * q0        r = 0
+  -a, r0 > 0 -> q = -sign(b) * (q0 + 1)  r = |b| - r0
 */
 
-static int8_t add_character_front(BigNum target, char c) {
-    if (target->size_ == 1 && target->digits_[0] == 0) {
-        target->digits_[0] = c;
-    } else {
-        char *new_digits = (char *) malloc(sizeof(char) * (target->size_ + 1));
-        if (new_digits == NULL) return ERROR;
-        new_digits[0] = c;
-        for (int i = 1; i < target->size_ + 1; i++) {
-            new_digits[i] = target->digits_[i - 1];
+//|lhs| = |rhs| * quotient + remainder, either output may be lhs but neither may be rhs
+//|lhs| by d of dn limbs, through the precomputed divisor if there is one
+static int8_t absolute_values_division(BigNum lhs, const limb_t *d, size_t dn, Divisor divisor,
+                                       BigNum quotient, BigNum remainder) {
+    size_t an = lhs->size_;
+    if (an < dn) {
+        if (reserve(remainder, dn, remainder == lhs) == ERROR || reserve(quotient, 2, quotient == lhs) == ERROR) {
+            return ERROR;
         }
-        free(target->digits_);
-        target->size_ += 1;
-        target->digits_ = new_digits;
+        if (remainder != lhs) memcpy(remainder->limbs_, lhs->limbs_, sizeof(limb_t) * an);
+        remainder->size_ = an;
+        quotient->limbs_[0] = 0;
+        quotient->size_ = 1;
+        return SUCCESS;
     }
+    //a limb more for the floor of a negative dividend, which may carry out of an all-ones quotient
+    size_t qn = an - dn + 1;
+    if (reserve(quotient, qn + 1, quotient == lhs) == ERROR || reserve(remainder, dn, remainder == lhs) == ERROR) {
+        return ERROR;
+    }
+    if ((divisor != NULL ? limbs_divmod_by(quotient->limbs_, remainder->limbs_, lhs->limbs_, an, divisor)
+                         : limbs_divmod(quotient->limbs_, remainder->limbs_, lhs->limbs_, an, d, dn)) == ERROR) {
+        return ERROR;
+    }
+    quotient->size_ = qn;
+    remainder->size_ = dn;
     return SUCCESS;
 }
 
-static int8_t absolute_values_division(BigNum lhs, BigNum rhs, BigNum quotient, BigNum remainder) {
-    remainder->sign_ = 1;
-    quotient->sign_ = 1;
-    for (int ind = lhs->size_ - 1; ind >= 0; ind--) {
-        if (add_character_front(remainder, lhs->digits_[ind]) == ERROR) return ERROR;
-        int8_t cmp = Compare(remainder, rhs);
-        if (cmp == -1) continue;
-        char cnt = 0;
-        while (cmp > -1) {
-            Sub(remainder, rhs, remainder);
-            cnt++;
-            cmp = Compare(remainder, rhs);
-        }
-        if (!(ind == 0 && cnt == 0)) {
-            if (add_character_front(quotient, cnt) == ERROR) return ERROR;
+//DivMod by d of dn limbs and sign d_sign, which the outputs must not overlap
+static int8_t signed_division(BigNum lhs, const limb_t *d, size_t dn, int d_sign, Divisor divisor,
+                              BigNum quotient, BigNum remainder) {
+    STAT_CALL(STAT_DIVMOD, lhs->size_);
+    int lhs_sign = lhs->sign_;
+    //missing outputs need scratch space
+    BigNum tmp_quotient = quotient == NULL ? CreateNum() : quotient;
+    BigNum tmp_remainder = remainder == NULL ? CreateNum() : remainder;
+    int8_t code = tmp_quotient == NULL || tmp_remainder == NULL ? ERROR : SUCCESS;
+
+    if (code == SUCCESS) code = absolute_values_division(lhs, d, dn, divisor, tmp_quotient, tmp_remainder);
+    if (code == SUCCESS) {
+        tmp_quotient->sign_ = lhs_sign == d_sign ? 1 : -1;
+        tmp_remainder->sign_ = 1;
+        normalize(tmp_remainder);
+        if (lhs_sign == -1 && !num_is_zero(tmp_remainder)) {
+            limb_t carry = limbs_add_1(tmp_quotient->limbs_, tmp_quotient->limbs_, tmp_quotient->size_, 1);
+            if (carry != 0) tmp_quotient->limbs_[tmp_quotient->size_++] = carry;
+            limbs_sub(tmp_remainder->limbs_, d, dn, tmp_remainder->limbs_, tmp_remainder->size_);
+            tmp_remainder->size_ = dn;
+            normalize(tmp_remainder);
         }
+        normalize(tmp_quotient);
     }
-    return SUCCESS;
-}
 
-#define release(a, b, c, d) \
-    {                 \
-        FreeNum((a));  \
-        FreeNum((b));  \
-        FreeNum((c));  \
-        FreeNum((d));\
-    }
+    if (tmp_quotient != quotient) FreeNum(tmp_quotient);
+    if (tmp_remainder != remainder) FreeNum(tmp_remainder);
+    return code;
+}
 
 int8_t DivMod(BigNum lhs, BigNum rhs, BigNum quotient, BigNum remainder) {
     if (quotient == NULL && remainder == NULL) return ERROR;
-    if (rhs->size_ == 1 && rhs->digits_[0] == 0) return ERROR;
-
-    BigNum lhs_abs = CreateNum();
-    BigNum rhs_abs = CreateNum();
-    BigNum tmp_quotient = CreateNum();
-    BigNum tmp_remainder = CreateNum();;
+    if (quotient == remainder || lhs == NULL || rhs == NULL || num_is_zero(rhs)) return ERROR;
 
-    if (tmp_quotient == NULL || tmp_remainder == NULL || rhs_abs == NULL || lhs_abs == NULL ||
-        Abs(lhs, lhs_abs) == ERROR || Abs(rhs, rhs_abs) == ERROR) {
-        release(lhs_abs, rhs_abs, tmp_quotient, tmp_remainder);
+    //|rhs| is still needed after the outputs are written
+    BigNum divisor = rhs == quotient || rhs == remainder ? CreateNum() : rhs;
+    if (divisor == NULL || (divisor != rhs && CopyNum(rhs, divisor) == ERROR)) {
+        if (divisor != rhs) FreeNum(divisor);
         return ERROR;
     }
+    int8_t code = signed_division(lhs, divisor->limbs_, divisor->size_, rhs->sign_, NULL, quotient, remainder);
+    if (divisor != rhs) FreeNum(divisor);
+    return code;
+}
 
-    if (Compare(lhs_abs, rhs_abs) == -1) {
-        if (lhs->sign_ == 1) {
-            if (SetFromStr(tmp_quotient, "0") == ERROR || CopyNum(lhs, tmp_remainder) == ERROR) {
-                release(lhs_abs, rhs_abs, tmp_quotient, tmp_remainder);
-                return ERROR;
-            }
-        } else {
-            if (SetFromStr(tmp_quotient, rhs->sign_ == -1 ? "1" : "-1") == ERROR ||
-                Sub(rhs_abs, lhs_abs, tmp_remainder) == ERROR) {
-                release(lhs_abs, rhs_abs, tmp_quotient, tmp_remainder);
-                return ERROR;
-            }
-        }
-    } else {
-        if (absolute_values_division(lhs_abs, rhs_abs, tmp_quotient, tmp_remainder) == ERROR) {
-            release(lhs_abs, rhs_abs, tmp_quotient, tmp_remainder);
-            return ERROR;
-        }
-        if (lhs->sign_ == -1) {
-            BigNum unit = CreateNum();
-            if (unit == NULL || SetFromStr(unit, "1") == ERROR || Add(tmp_quotient, unit, tmp_quotient) == ERROR ||
-                Sub(rhs_abs, tmp_remainder, tmp_remainder) == ERROR) {
-                FreeNum(unit);
-                release(lhs_abs, rhs_abs, tmp_quotient, tmp_remainder);
-                return ERROR;
-            }
-            FreeNum(unit);
-            if (rhs->sign_ == 1) tmp_quotient->sign_ = -1;
-        } else if (rhs->sign_ == -1) tmp_quotient->sign_ = -1;
-
-    }
-    if (quotient != NULL) {
-        SwapNums(tmp_quotient, quotient);
-    }
-    if (remainder != NULL) {
-        SwapNums(tmp_remainder, remainder);
-    }
-    release(lhs_abs, rhs_abs, tmp_quotient, tmp_remainder);
-    return SUCCESS;
+int8_t DivModBy(BigNum lhs, Divisor divisor, BigNum quotient, BigNum remainder) {
+    if (quotient == NULL && remainder == NULL) return ERROR;
+    if (quotient == remainder || lhs == NULL || divisor == NULL) return ERROR;
+    return signed_division(lhs, divisor->d, divisor->n, divisor->sign, divisor, quotient, remainder);
 }
 
 int8_t Div(BigNum lhs, BigNum rhs, BigNum res) {
@@ -394,64 +521,31 @@ int8_t Mod(BigNum lhs, BigNum rhs, BigNum res) {
     return DivMod(lhs, rhs, NULL, res);
 }
 
-int8_t gcd(BigNum a, BigNum b, BigNum res) {
-    if (b->size_ == 1 && b->digits_[0] == 0) {
-        SwapNums(a, res);
-        return SUCCESS;
-    }
-    Mod(a, b, a);
-    return gcd(b, a, res);
-}
-
-int8_t GCD(BigNum lhs, BigNum rhs, BigNum res) {
-    BigNum tmp_lhs = CreateNum();
-    BigNum tmp_rhs = CreateNum();
-    BigNum tmp_res = CreateNum();
-    if (tmp_lhs == NULL || tmp_rhs == NULL || tmp_res == NULL ||
-        Abs(lhs, tmp_lhs) == ERROR || Abs(rhs, tmp_rhs) == ERROR) {
-        FreeNum(tmp_lhs);
-        FreeNum(tmp_rhs);
-        FreeNum(tmp_res);
-        return ERROR;
-    }
-    int8_t code = gcd(tmp_lhs, tmp_rhs, tmp_res);
-    if (code != ERROR) {
-        SwapNums(tmp_res, res);
-    }
-    FreeNum(tmp_lhs);
-    FreeNum(tmp_rhs);
-    FreeNum(tmp_res);
-    return code;
-}
-
 int8_t Compare(BigNum lhs, BigNum rhs) { // 0 = equal , 1 = lhs > rhs  -1 = lhs < rhs
     if (lhs->sign_ != rhs->sign_) return lhs->sign_ == 1 ? 1 : -1;
-    if (lhs->size_ > rhs->size_) return lhs->sign_ == 1 ? 1 : -1;
-    if (lhs->size_ < rhs->size_) return lhs->sign_ == 1 ? -1 : 1;
-    for (int i = lhs->size_ - 1; i >= 0; i--) {
-        if (lhs->digits_[i] != rhs->digits_[i]) return lhs->digits_[i] > rhs->digits_[i] ? 1 : -1;
+    if (lhs->size_ == 1 && rhs->size_ == 1) {
+        limb_t a = lhs->limbs_[0], b = rhs->limbs_[0];
+        return (int8_t) (a == b ? 0 : ((a > b) == (lhs->sign_ == 1) ? 1 : -1));
     }
-    return 0;
+    int8_t cmp = limbs_cmp(lhs->limbs_, lhs->size_, rhs->limbs_, rhs->size_);
+    return lhs->sign_ == 1 ? cmp : (int8_t) -cmp;
 }
 
 int8_t CopyNum(BigNum from, BigNum to) {
     if (to == NULL || from == NULL) return ERROR;
-    free(to->digits_);
+    if (from == to) return SUCCESS;
+    STAT_CALL(STAT_COPY, from->size_);
+    if (reserve(to, from->size_, false) == ERROR) return ERROR;
     to->size_ = from->size_;
     to->sign_ = from->sign_;
-    to->digits_ = (char *) malloc(sizeof(char) * to->size_);
-    if (to->digits_ == NULL) return ERROR;
-    for (int i = 0; i < to->size_; i++) {
-        to->digits_[i] = from->digits_[i];
-    }
+    if (to->size_ != 0) memcpy(to->limbs_, from->limbs_, sizeof(limb_t) * to->size_);
     return SUCCESS;
 }
 
 void FreeNum(BigNum num) {
     if (num != NULL) {
-        num->size_ = 0;
+        num_release_storage(num);
         num->sign_ = 0;
-        free(num->digits_);
     }
-    free(num);
+    num_free(num);
 }
@@ -4,32 +4,204 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
-//little-endian
-struct BigNum { //0 - 49 9 - 57
-    char *digits_;
-    size_t size_; //amount of digits
+typedef uint64_t limb_t;
+#define LIMB_BITS 64
+
+//allocator of digit storage, see CreateArenaCtx and CreatePoolCtx
+typedef struct NumCtx *NumCtx;
+
+//magnitudes up to this many limbs live inside the struct and need no storage of their own
+#define NUM_INLINE_LIMBS 2
+
+//little-endian, base 2^64
+struct BigNum {
+    limb_t *limbs_; //inline_ until the value outgrows it
+    size_t size_; //amount of limbs
+    size_t capacity_; //allocated limbs, 0 for views of foreign memory
     int sign_; //-1 0 1
+    NumCtx ctx_; //where new storage comes from, NULL stands for the allocation hooks
+    limb_t inline_[NUM_INLINE_LIMBS];
 };
 typedef struct BigNum *BigNum;
 
 #define SUCCESS 0
 #define ERROR 1
 
+//allocates from the context of the calling thread, see SetThreadCtx
 BigNum CreateNum();
 
+BigNum CreateNumIn(NumCtx ctx);
+
 int8_t SetFromStr(BigNum target, char const *str);
 
 char *ToStr(BigNum num);
 
+//bases 2..36, letters of either case stand for the digits above 9
+int8_t SetFromStrBase(BigNum target, char const *str, int base);
+
+//lowercase digits, null if the base is out of range or memory runs out
+char *ToStrBase(BigNum num, int base);
+
+//decimal digits in buf[0..len), no terminator needed
+int8_t SetFromBuf(BigNum target, char const *buf, size_t len);
+
+//writes the decimal digits without a terminator and stores their count in len, ERROR if cap is too small
+int8_t ToBuf(BigNum num, char *out, size_t cap, size_t *len);
+
+/*
+  Streamed decimal input and output, the digit text is never held in full.
+  ReadNum skips leading whitespace and leaves the first character after the digits in the stream,
+  ReadNumFd reads in blocks and consumes its input up to the end of the number or a bit beyond.
+*/
+int8_t ReadNum(BigNum target, FILE *stream);
+
+int8_t ReadNumFd(BigNum target, int fd);
+
+int8_t WriteNum(BigNum num, FILE *stream);
+
+int8_t WriteNumFd(BigNum num, int fd);
+
+/*
+  Versioned binary format: a 16-byte header with the sign and the limb count, then little-endian limbs.
+  ViewNum makes num read the limbs where they are, e.g. in an mmap'd file, which must outlive it.
+  A view is copied into storage of its own before the first write, data is never modified.
+  ViewNum needs a little-endian host and limbs aligned to 8 bytes.
+*/
+size_t SerializedSize(BigNum num);
+
+int8_t SerializeNum(BigNum num, void *out, size_t cap, size_t *len);
+
+int8_t DeserializeNum(BigNum target, const void *data, size_t len);
+
+int8_t ViewNum(BigNum view, const void *data, size_t len);
+
 int8_t Add(BigNum lhs, BigNum rhs, BigNum res);
 
 int8_t Sub(BigNum lhs, BigNum rhs, BigNum res);
 
+//lhs == rhs is computed as a square
 int8_t Mult(BigNum lhs, BigNum rhs, BigNum res);
 
+int8_t Sqr(BigNum x, BigNum res);
+
 int8_t DivMod(BigNum lhs, BigNum rhs, BigNum quotient, BigNum remainder);
 
+//acc = acc op x, the storage of acc is reused whenever it is large enough
+int8_t AddInPlace(BigNum acc, BigNum x);
+
+int8_t SubInPlace(BigNum acc, BigNum x);
+
+int8_t MultInPlace(BigNum acc, BigNum x);
+
+/*
+  acc = acc +- a * b without a temporary for the product: small products are accumulated row by row
+  in the storage of acc, which grows once if it has to. acc may be a or b.
+  Numbers that were never set count as 0, acc and operands alike.
+*/
+int8_t AddMul(BigNum acc, BigNum a, BigNum b);
+
+int8_t SubMul(BigNum acc, BigNum a, BigNum b);
+
+int8_t AddMulUi(BigNum acc, BigNum a, uint64_t b);
+
+int8_t SubMulUi(BigNum acc, BigNum a, uint64_t b);
+
+/*
+  Batches of independent operations, res[i] = a[i] op b[i] for i < n.
+  Every result is made large enough before the arithmetic starts, which then runs on the thread pool
+  if one is set and the batch is large enough, see SetThreadPool.
+  res[i] may be a[i] or b[i] but no other entry's operand or result. On ERROR some results may be unset.
+*/
+int8_t AddBatch(const BigNum *a, const BigNum *b, BigNum *res, size_t n);
+
+int8_t SubBatch(const BigNum *a, const BigNum *b, BigNum *res, size_t n);
+
+int8_t MultBatch(const BigNum *a, const BigNum *b, BigNum *res, size_t n);
+
+int8_t CompareBatch(const BigNum *a, const BigNum *b, int8_t *res, size_t n);
+
+/*
+  Struct-of-arrays batches of count unsigned operands, width limbs each: limb j of operand i is at [j * count + i].
+  The loops run across operands, so they vectorize; meant for many operands of a few limbs.
+  r may coincide with a or b, carry and borrow receive one limb per operand and may be NULL.
+*/
+void AddSoA(limb_t *r, limb_t *carry, const limb_t *a, const limb_t *b, size_t width, size_t count);
+
+void SubSoA(limb_t *r, limb_t *borrow, const limb_t *a, const limb_t *b, size_t width, size_t count);
+
+void CompareSoA(int8_t *res, const limb_t *a, const limb_t *b, size_t width, size_t count);
+
+/*
+  Expressions such as a * b + c * d - e, recorded as a graph of nodes and evaluated in one pass.
+  Sums are accumulated in place and products inside them are added or subtracted straight into the sum,
+  temporaries come from one block of the expression that is sized before evaluation and kept for the next one,
+  and the result is reserved once. Numbers are read when the expression is evaluated, not when it is built,
+  and a node may be used several times, it is computed once.
+  The builders return EXPR_INVALID when memory runs out or an operand is invalid, so calls can be nested.
+*/
+typedef struct Expr *Expr;
+typedef size_t ExprNode;
+
+#define EXPR_INVALID ((ExprNode) -1)
+
+Expr CreateExpr();
+
+void FreeExpr(Expr expr);
+
+ExprNode ExprNum(Expr expr, BigNum num);
+
+ExprNode ExprAdd(Expr expr, ExprNode lhs, ExprNode rhs);
+
+ExprNode ExprSub(Expr expr, ExprNode lhs, ExprNode rhs);
+
+ExprNode ExprMult(Expr expr, ExprNode lhs, ExprNode rhs);
+
+//res may be one of the numbers of the expression
+int8_t EvalExpr(Expr expr, ExprNode root, BigNum res);
+
+/*
+  Modular exponentiation, res = base^exp mod |mod| in [0, |mod|), exp must not be negative.
+  A modulus context holds what PowMod would otherwise precompute on every call:
+  Montgomery constants for odd moduli, Barrett's reciprocal for even ones.
+*/
+typedef struct ModCtx *ModCtx;
+
+ModCtx CreateModCtx(BigNum mod); //NULL for a zero modulus or when memory runs out
+
+void FreeModCtx(ModCtx ctx);
+
+int8_t PowMod(BigNum base, BigNum exp, BigNum mod, BigNum res);
+
+int8_t PowModCtx(BigNum base, BigNum exp, ModCtx ctx, BigNum res);
+
+/*
+  Constant-time arithmetic for secret operands such as key material.
+  Values are unsigned and live in caller-provided buffers of n limbs, leading zeroes included,
+  so the running time and the memory accesses depend on the widths only, never on the values.
+  CtPowMod needs an odd modulus; the modulus and the exponent width are not secret.
+*/
+int8_t CtFromNum(limb_t *r, size_t n, BigNum num); //ERROR for negative numbers and those wider than n limbs
+
+int8_t CtToNum(BigNum num, const limb_t *a, size_t n);
+
+limb_t CtAdd(limb_t *r, const limb_t *a, const limb_t *b, size_t n); //returns the carry
+
+limb_t CtSub(limb_t *r, const limb_t *a, const limb_t *b, size_t n); //returns the borrow
+
+void CtMult(limb_t *r, const limb_t *a, const limb_t *b, size_t n); //r has 2n limbs and must not overlap a or b
+
+int8_t CtCompare(const limb_t *a, const limb_t *b, size_t n);
+
+void CtSwap(limb_t *a, limb_t *b, size_t n, limb_t cond); //swaps when cond is 1, cond must be 0 or 1
+
+//base and r have as many limbs as the modulus, r = base^exp mod m
+int8_t CtPowMod(limb_t *r, const limb_t *base, const limb_t *exp, size_t en, ModCtx ctx);
+
+//makes room for limbs limbs without changing the value
+int8_t ReserveNum(BigNum num, size_t limbs);
+
 
 int8_t CopyNum(BigNum from, BigNum to);
 
@@ -40,10 +212,153 @@ int8_t Div(BigNum lhs, BigNum rhs, BigNum res);
 
 int8_t Mod(BigNum lhs, BigNum rhs, BigNum res);
 
+/*
+  Repeated division by the same number. A divisor keeps its value shifted to a set top bit together with
+  the Möller-Granlund reciprocal of the top limbs, so quotient limbs take multiplications instead of divisions.
+*/
+typedef struct Divisor *Divisor;
+
+Divisor CreateDivisor(BigNum d); //NULL for zero or when memory runs out
+
+void FreeDivisor(Divisor divisor);
+
+//the results of DivMod(lhs, d, quotient, remainder)
+int8_t DivModBy(BigNum lhs, Divisor divisor, BigNum quotient, BigNum remainder);
+
+//res = gcd(|lhs|, |rhs|), Lehmer's algorithm and the half-GCD from THRESHOLD_HGCD limbs on
 int8_t GCD(BigNum lhs, BigNum rhs, BigNum res);
 
+//g = gcd(a, b) = s * a + t * b with |s| <= |b| / 2g for b != 0; s or t may be NULL, g must differ from both
+int8_t ExtGCD(BigNum a, BigNum b, BigNum g, BigNum s, BigNum t);
+
+//res = a^-1 mod |mod| in [0, |mod|), ERROR when a and mod are not coprime
+int8_t ModInverse(BigNum a, BigNum mod, BigNum res);
+
 void FreeNum(BigNum num);
 
 void SwapNums(BigNum lhs, BigNum rhs);
 
+/*
+  Allocation of digit storage.
+  An arena hands out memory by bumping a pointer and gets it back only in ReleaseCtx or FreeCtx,
+  which invalidates every number allocated from it. A pool keeps freed blocks in power-of-two size classes.
+  Contexts are not synchronized, each thread should own its own one.
+  Numbers of different contexts may be mixed freely, storage always returns to the context it came from.
+*/
+NumCtx CreateArenaCtx(size_t chunk_size); //0 picks a default chunk size
+
+NumCtx CreatePoolCtx();
+
+//arena: drops everything allocated so far, pool: returns cached blocks to the hooks
+void ReleaseCtx(NumCtx ctx);
+
+//a pool must not have live numbers left
+void FreeCtx(NumCtx ctx);
+
+//context used by CreateNum and by the temporaries of DivMod and GCD on the calling thread
+void SetThreadCtx(NumCtx ctx);
+
+NumCtx GetThreadCtx();
+
+//replaces malloc, realloc and free for everything but the strings of ToStr, NULL restores the default
+void SetAllocFunctions(void *(*alloc)(size_t), void *(*realloc_fn)(void *, size_t), void (*free_fn)(void *));
+
+/*
+  Multi-threaded products. With a pool set on the calling thread, Mult, Sqr and the products inside DivMod
+  split operands of at least the grain size across the pool: the sub-products of Karatsuba and Toom-3,
+  the pieces of unbalanced products and the transforms of the NTT. Results do not depend on the pool.
+  Worker threads call the allocation hooks, which then have to be thread-safe, the defaults are.
+  Without a pool, the default, everything runs on the calling thread.
+*/
+typedef struct ThreadPool *ThreadPool;
+
+//threads counts the calling thread too, 0 starts one per CPU; NULL if threads cannot be started
+ThreadPool CreateThreadPool(size_t threads);
+
+//no thread may be using the pool
+void FreeThreadPool(ThreadPool pool);
+
+//limbs of the smaller operand from which work is split, ERROR for 0
+int8_t SetPoolGrain(ThreadPool pool, size_t limbs);
+
+//pool used by the calling thread, NULL runs single-threaded; a pool may serve several threads at once
+void SetThreadPool(ThreadPool pool);
+
+ThreadPool GetThreadPool();
+
+/*
+  Statistics of the work of the library, collected only when it is built with the NUM_STATS option:
+  calls and operand sizes of the public operations, the algorithms that ran with their time, and allocations.
+  Every thread counts on its own without locks, snapshots sum up all threads. Without the option nothing is counted.
+*/
+enum StatOp {
+    STAT_CREATE,
+    STAT_COPY,
+    STAT_ADD, //Sub included
+    STAT_MULT,
+    STAT_SQR,
+    STAT_ADD_MUL, //SubMul and the word variants included
+    STAT_DIVMOD, //Div, Mod and DivModBy included
+    STAT_GCD,
+    STAT_POW_MOD,
+    STAT_SET_STR,
+    STAT_TO_STR,
+    STAT_OPS_COUNT
+};
+
+//the algorithm a product, division or GCD picked; products count every level of their recursion, the others the top one
+enum StatTier {
+    STAT_MUL_BASECASE,
+    STAT_MUL_KARATSUBA,
+    STAT_MUL_TOOM3,
+    STAT_MUL_UNBALANCED,
+    STAT_MUL_NTT,
+    STAT_SQR_BASECASE,
+    STAT_SQR_KARATSUBA,
+    STAT_SQR_TOOM3,
+    STAT_SQR_NTT,
+    STAT_DIV_1, //single-limb divisors
+    STAT_DIV_BASECASE,
+    STAT_DIV_BZ,
+    STAT_GCD_LEHMER,
+    STAT_GCD_HGCD,
+    STAT_TIERS_COUNT
+};
+
+//bucket 0 counts operands of one limb, bucket b those of 2^(b-1) + 1 to 2^b limbs, the last one all larger ones
+#define STAT_SIZE_BUCKETS 24
+
+struct NumStats {
+    uint64_t calls[STAT_OPS_COUNT];
+    uint64_t sizes[STAT_OPS_COUNT][STAT_SIZE_BUCKETS]; //limbs of the larger operand
+    uint64_t tier_calls[STAT_TIERS_COUNT];
+    uint64_t tier_ns[STAT_TIERS_COUNT]; //time of the outermost tier of every thread, nested ones count in it
+    uint64_t allocations, reallocations, frees; //of digit storage and scratch buffers, a moved block counts in all three
+    uint64_t bytes_allocated, bytes_reallocated; //requested sizes, the new one for reallocations
+};
+
+//totals over all threads since the last reset, ERROR if the library was built without NUM_STATS
+int8_t GetNumStats(struct NumStats *stats);
+
+void ResetNumStats();
+
+//algorithm crossover points, measured in limbs of the smaller operand
+enum Threshold {
+    THRESHOLD_MUL_KARATSUBA, //schoolbook below, Karatsuba from here on
+    THRESHOLD_MUL_TOOM3, //Karatsuba below, Toom-3 from here on
+    THRESHOLD_MUL_NTT, //number-theoretic transform from here on
+    THRESHOLD_SQR_KARATSUBA, //the same three crossovers for squares
+    THRESHOLD_SQR_TOOM3,
+    THRESHOLD_SQR_NTT,
+    THRESHOLD_DIV_BZ, //divisor limbs from which Knuth's algorithm D gives way to Burnikel-Ziegler
+    THRESHOLD_HGCD, //limbs from which GCDs reduce in half-GCD batches instead of Lehmer's steps
+    THRESHOLD_GET_STR_DC, //limbs from which ToStr splits the number in halves
+    THRESHOLD_SET_STR_DC, //limbs from which SetFromStr splits the digits in halves
+    THRESHOLDS_COUNT
+};
+
+int8_t SetThreshold(enum Threshold threshold, size_t limbs);
+
+size_t GetThreshold(enum Threshold threshold);
+
 #endif //ARBITARYPRECISIONARITHMETICS_NUMBER_H
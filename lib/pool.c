@@ -0,0 +1,212 @@
+#include "limbs.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+  Fork-join over a shared queue. A thread that submits tasks runs the first one itself and then keeps taking
+  tasks from the queue, its own or anybody's, until all of its tasks are done. Tasks may submit tasks of their own,
+  somebody is always running the queue, so nested splits cannot deadlock.
+*/
+
+#define DEFAULT_GRAIN 2048
+
+//tasks submitted together, pending is guarded by the pool lock
+struct batch {
+    size_t pending;
+};
+
+struct job {
+    struct task *task;
+    struct batch *batch;
+    struct job *next;
+};
+
+struct ThreadPool {
+    pthread_mutex_t lock;
+    pthread_cond_t changed; //a job was queued or a batch completed
+    struct job *head, *tail;
+    bool stop;
+    size_t grain;
+    size_t workers;
+    pthread_t threads[];
+};
+
+static _Thread_local ThreadPool thread_pool = NULL;
+
+//returns with the lock held
+static void run_job(ThreadPool pool, struct job *job) {
+    job->task->code = job->task->run(job->task->arg);
+    pthread_mutex_lock(&pool->lock);
+    if (--job->batch->pending == 0) pthread_cond_broadcast(&pool->changed);
+}
+
+//takes the first queued job, the lock is held
+static struct job *pop_job(ThreadPool pool) {
+    struct job *job = pool->head;
+    if (job != NULL) {
+        pool->head = job->next;
+        if (pool->head == NULL) pool->tail = NULL;
+    }
+    return job;
+}
+
+static void *worker(void *arg) {
+    ThreadPool pool = (ThreadPool) arg;
+    thread_pool = pool;
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop) {
+        struct job *job = pop_job(pool);
+        if (job == NULL) {
+            pthread_cond_wait(&pool->changed, &pool->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        run_job(pool, job);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool CreateThreadPool(size_t threads) {
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t) cpus : 1;
+    }
+    ThreadPool pool = (ThreadPool) malloc(sizeof(struct ThreadPool) + sizeof(pthread_t) * (threads - 1));
+    if (pool == NULL) return NULL;
+    pool->head = pool->tail = NULL;
+    pool->stop = false;
+    pool->grain = DEFAULT_GRAIN;
+    pool->workers = 0;
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) {
+        free(pool);
+        return NULL;
+    }
+    if (pthread_cond_init(&pool->changed, NULL) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+        return NULL;
+    }
+    //the thread that submits the work is the last one
+    while (pool->workers < threads - 1) {
+        if (pthread_create(&pool->threads[pool->workers], NULL, worker, pool) != 0) {
+            FreeThreadPool(pool);
+            return NULL;
+        }
+        pool->workers++;
+    }
+    return pool;
+}
+
+void FreeThreadPool(ThreadPool pool) {
+    if (pool == NULL) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->changed);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < pool->workers; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    if (thread_pool == pool) thread_pool = NULL;
+    pthread_cond_destroy(&pool->changed);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+int8_t SetPoolGrain(ThreadPool pool, size_t limbs) {
+    if (pool == NULL || limbs == 0) return ERROR;
+    pool->grain = limbs;
+    return SUCCESS;
+}
+
+void SetThreadPool(ThreadPool pool) {
+    thread_pool = pool;
+}
+
+ThreadPool GetThreadPool() {
+    return thread_pool;
+}
+
+bool parallel_worth(size_t limbs) {
+    return thread_pool != NULL && thread_pool->workers != 0 && limbs >= thread_pool->grain;
+}
+
+size_t parallel_threads() {
+    return thread_pool == NULL ? 1 : thread_pool->workers + 1;
+}
+
+int8_t parallel_run(struct task *tasks, size_t count) {
+    ThreadPool pool = thread_pool;
+    struct job *jobs = NULL;
+    if (pool != NULL && pool->workers != 0 && count > 1) jobs = (struct job *) scratch_alloc(sizeof(struct job) * count);
+    if (jobs == NULL) {
+        int8_t code = SUCCESS;
+        for (size_t i = 0; i < count; i++) {
+            if (tasks[i].run(tasks[i].arg) == ERROR) code = ERROR;
+        }
+        return code;
+    }
+
+    struct batch batch = {count - 1};
+    pthread_mutex_lock(&pool->lock);
+    for (size_t i = 1; i < count; i++) {
+        jobs[i] = (struct job) {&tasks[i], &batch, NULL};
+        if (pool->tail == NULL) {
+            pool->head = &jobs[i];
+        } else {
+            pool->tail->next = &jobs[i];
+        }
+        pool->tail = &jobs[i];
+    }
+    pthread_cond_broadcast(&pool->changed);
+    pthread_mutex_unlock(&pool->lock);
+
+    tasks[0].code = tasks[0].run(tasks[0].arg);
+    pthread_mutex_lock(&pool->lock);
+    while (batch.pending != 0) {
+        struct job *job = pop_job(pool);
+        if (job == NULL) {
+            pthread_cond_wait(&pool->changed, &pool->lock);
+            continue;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        run_job(pool, job);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    scratch_free(jobs);
+
+    int8_t code = SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        if (tasks[i].code == ERROR) code = ERROR;
+    }
+    return code;
+}
+
+struct range_task {
+    int8_t (*body)(void *ctx, size_t begin, size_t end);
+    void *ctx;
+    size_t begin, end;
+};
+
+static int8_t run_range(void *arg) {
+    struct range_task *range = (struct range_task *) arg;
+    return range->body(range->ctx, range->begin, range->end);
+}
+
+int8_t parallel_for(size_t count, size_t min_chunk, int8_t (*body)(void *ctx, size_t begin, size_t end), void *ctx) {
+    size_t chunks = parallel_threads();
+    if (min_chunk == 0) min_chunk = 1;
+    if (count / min_chunk < chunks) chunks = count / min_chunk;
+    struct task *tasks = chunks > 1 ? (struct task *) scratch_alloc(
+            (sizeof(struct task) + sizeof(struct range_task)) * chunks) : NULL;
+    if (tasks == NULL) return body(ctx, 0, count);
+    struct range_task *ranges = (struct range_task *) (tasks + chunks);
+    for (size_t i = 0; i < chunks; i++) {
+        ranges[i] = (struct range_task) {body, ctx, count * i / chunks, count * (i + 1) / chunks};
+        tasks[i] = (struct task) {run_range, &ranges[i], SUCCESS};
+    }
+    int8_t code = parallel_run(tasks, chunks);
+    scratch_free(tasks);
+    return code;
+}
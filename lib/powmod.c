@@ -0,0 +1,210 @@
+#include "number.h"
+#include "limbs.h"
+#include "stats.h"
+#include <string.h>
+
+/*
+  Residues are kept as n-limb arrays, n being the size of the modulus m.
+  Odd moduli use Montgomery form x * B^n mod m, so a reduction is n multiply-adds of m with no division.
+  Even moduli use Barrett's method with mu = B^2n / m, which costs two products per reduction.
+  Both reduce a product of two residues, 2n limbs, back to n limbs.
+*/
+
+//limbs of scratch space the reductions need besides the 2n limbs of the product
+#define REDUCE_SCRATCH(n) (4 * (n) + 6)
+
+ModCtx CreateModCtx(BigNum mod) {
+    if (mod == NULL || mod->size_ == 0 || (mod->size_ == 1 && mod->limbs_[0] == 0)) return NULL;
+    size_t n = mod->size_;
+    ModCtx ctx = (ModCtx) scratch_alloc(sizeof(struct ModCtx));
+    limb_t *limbs = (limb_t *) scratch_alloc(sizeof(limb_t) * (3 * n + 2));
+    //B^2n, then the quotient of its division by m
+    limb_t *power = (limb_t *) scratch_alloc(sizeof(limb_t) * (3 * n + 3));
+    if (ctx == NULL || limbs == NULL || power == NULL) {
+        scratch_free(ctx);
+        scratch_free(limbs);
+        scratch_free(power);
+        return NULL;
+    }
+    ctx->n = n;
+    ctx->m = limbs;
+    ctx->r2 = limbs + n;
+    ctx->mu = limbs + 2 * n;
+    memcpy(ctx->m, mod->limbs_, sizeof(limb_t) * n);
+    ctx->montgomery = (ctx->m[0] & 1) != 0;
+
+    memset(power, 0, sizeof(limb_t) * 2 * n);
+    power[2 * n] = 1;
+    limb_t *quotient = power + 2 * n + 1;
+    if (limbs_divmod(quotient, ctx->r2, power, 2 * n + 1, ctx->m, n) == ERROR) {
+        scratch_free(power);
+        FreeModCtx(ctx);
+        return NULL;
+    }
+    ctx->mun = limbs_normalized_size(quotient, n + 2);
+    memcpy(ctx->mu, quotient, sizeof(limb_t) * ctx->mun);
+    scratch_free(power);
+
+    //Newton's iteration doubles the correct low bits of the inverse, m * m = 1 mod 8 gives the first three
+    limb_t inv = ctx->m[0];
+    for (int i = 0; i < 5; i++) {
+        inv *= 2 - ctx->m[0] * inv;
+    }
+    ctx->minv = -inv;
+    return ctx;
+}
+
+void FreeModCtx(ModCtx ctx) {
+    if (ctx == NULL) return;
+    scratch_free(ctx->m);
+    scratch_free(ctx);
+}
+
+//r = t * B^-n mod m, t has 2n limbs, is below m * B^n and gets overwritten
+static void redc(limb_t *r, limb_t *t, const struct ModCtx *ctx) {
+    size_t n = ctx->n;
+    for (size_t i = 0; i < n; i++) {
+        //t[i] becomes zero, so it can hold the carry that belongs to t[i + n]
+        t[i] = limbs_addmul_1(t + i, ctx->m, n, t[i] * ctx->minv);
+    }
+    limb_t carry = limbs_add_n(r, t + n, t, n);
+    if (carry != 0 || limbs_cmp(r, n, ctx->m, n) != -1) limbs_sub_n(r, r, ctx->m, n);
+}
+
+//r = t mod m, t has 2n limbs and is below m^2
+static int8_t barrett(limb_t *r, const limb_t *t, const struct ModCtx *ctx, limb_t *scratch) {
+    size_t n = ctx->n;
+    limb_t *q = scratch, *qm = scratch + 2 * n + 3;
+    //q = (t / B^(n-1)) * mu / B^(n+1) underestimates t / m by at most 2
+    size_t tn = limbs_normalized_size(t + n - 1, n + 1);
+    if (limbs_mul(q, t + n - 1, tn, ctx->mu, ctx->mun) == ERROR) return ERROR;
+    size_t qn = tn + ctx->mun > n + 1 ? limbs_normalized_size(q + n + 1, tn + ctx->mun - n - 1) : 0;
+    memset(qm, 0, sizeof(limb_t) * (n + 1));
+    if (qn != 0 && limbs_mul(qm, q + n + 1, qn, ctx->m, n) == ERROR) return ERROR;
+    //the remainder is below 3m < B^(n+1), so the top limbs of the product cancel out
+    limbs_sub_n(q, t, qm, n + 1);
+    while (q[n] != 0 || limbs_cmp(q, n, ctx->m, n) != -1) {
+        q[n] -= limbs_sub_n(q, q, ctx->m, n);
+    }
+    memcpy(r, q, sizeof(limb_t) * n);
+    return SUCCESS;
+}
+
+//r = a * b in the representation of ctx, scratch has 2n + REDUCE_SCRATCH(n) limbs
+static int8_t mod_mul(limb_t *r, const limb_t *a, const limb_t *b, const struct ModCtx *ctx, limb_t *scratch) {
+    size_t n = ctx->n;
+    if (limbs_mul(scratch, a, n, b, n) == ERROR) return ERROR;
+    if (ctx->montgomery) {
+        redc(r, scratch, ctx);
+        return SUCCESS;
+    }
+    return barrett(r, scratch, ctx, scratch + 2 * n);
+}
+
+static bool exp_bit(const limb_t *e, size_t i) {
+    return (e[i / LIMB_BITS] >> (i % LIMB_BITS)) & 1;
+}
+
+//longer windows need fewer multiplications but a table of 2^(k-1) odd powers
+static int window_size(size_t bits) {
+    static const size_t limits[] = {7, 25, 81, 241, 673};
+    int k = 1;
+    while (k <= 5 && bits > limits[k - 1]) {
+        k++;
+    }
+    return k;
+}
+
+int8_t PowModCtx(BigNum base, BigNum exp, ModCtx ctx, BigNum res) {
+    if (base == NULL || exp == NULL || ctx == NULL || res == NULL || exp->sign_ == -1) return ERROR;
+    size_t n = ctx->n;
+    STAT_CALL(STAT_POW_MOD, n);
+    //an exponent that was never set counts as 0, like a base
+    size_t bits = 0;
+    if (exp->size_ != 0) bits = exp->size_ * LIMB_BITS - __builtin_clzll(exp->limbs_[exp->size_ - 1] | 1);
+    if (exp->size_ == 1 && exp->limbs_[0] == 0) bits = 0;
+    int k = window_size(bits);
+    size_t table_size = (size_t) 1 << (k - 1);
+    size_t bn = base->size_;
+    size_t work = 2 * n + REDUCE_SCRATCH(n);
+    if (bn + 1 > work) work = bn + 1;
+
+    limb_t *scratch = (limb_t *) scratch_alloc(sizeof(limb_t) * ((table_size + 2) * n + work));
+    if (scratch == NULL) return ERROR;
+    limb_t *table = scratch, *acc = scratch + table_size * n, *x = acc + n, *ws = x + n;
+    int8_t code = SUCCESS;
+
+    //x = |base| mod m, then the sign
+    memset(x, 0, sizeof(limb_t) * n);
+    if (limbs_cmp(base->limbs_, bn, ctx->m, n) == -1) {
+        memcpy(x, base->limbs_, sizeof(limb_t) * (bn < n ? bn : n));
+    } else {
+        code = limbs_divmod(ws, x, base->limbs_, bn, ctx->m, n);
+    }
+    if (base->sign_ == -1 && (limbs_normalized_size(x, n) > 1 || x[0] != 0)) limbs_sub_n(x, ctx->m, x, n);
+
+    //table[i] = x^(2i + 1)
+    if (code == SUCCESS && ctx->montgomery) code = mod_mul(x, x, ctx->r2, ctx, ws);
+    memcpy(table, x, sizeof(limb_t) * n);
+    if (code == SUCCESS && table_size > 1) code = mod_mul(acc, x, x, ctx, ws);
+    for (size_t i = 1; i < table_size && code == SUCCESS; i++) {
+        code = mod_mul(table + i * n, table + (i - 1) * n, acc, ctx, ws);
+    }
+
+    //left to right, every window starts and ends with a one bit
+    bool started = false;
+    for (size_t i = bits; i-- > 0 && code == SUCCESS;) {
+        if (!exp_bit(exp->limbs_, i)) {
+            code = mod_mul(acc, acc, acc, ctx, ws);
+            continue;
+        }
+        size_t j = i + 1 >= (size_t) k ? i + 1 - k : 0;
+        while (!exp_bit(exp->limbs_, j)) {
+            j++;
+        }
+        size_t window = 0;
+        for (size_t b = i + 1; b-- > j;) {
+            window = window << 1 | exp_bit(exp->limbs_, b);
+        }
+        if (started) {
+            for (size_t s = j; s <= i && code == SUCCESS; s++) {
+                code = mod_mul(acc, acc, acc, ctx, ws);
+            }
+            if (code == SUCCESS) code = mod_mul(acc, acc, table + (window >> 1) * n, ctx, ws);
+        } else {
+            memcpy(acc, table + (window >> 1) * n, sizeof(limb_t) * n);
+            started = true;
+        }
+        i = j;
+    }
+
+    if (code == SUCCESS) {
+        if (!started) {
+            //x^0 = 1, which is 0 modulo 1
+            memset(acc, 0, sizeof(limb_t) * n);
+            acc[0] = n > 1 || ctx->m[0] != 1;
+        } else if (ctx->montgomery) {
+            memcpy(ws, acc, sizeof(limb_t) * n);
+            memset(ws + n, 0, sizeof(limb_t) * n);
+            redc(acc, ws, ctx);
+        }
+        res->size_ = 0;
+        code = ReserveNum(res, n);
+    }
+    if (code == SUCCESS) {
+        memcpy(res->limbs_, acc, sizeof(limb_t) * n);
+        res->size_ = limbs_normalized_size(acc, n);
+        res->sign_ = 1;
+    }
+    scratch_free(scratch);
+    return code;
+}
+
+int8_t PowMod(BigNum base, BigNum exp, BigNum mod, BigNum res) {
+    if (base == NULL || exp == NULL || mod == NULL || res == NULL || exp->sign_ == -1) return ERROR;
+    ModCtx ctx = CreateModCtx(mod);
+    if (ctx == NULL) return ERROR;
+    int8_t code = PowModCtx(base, exp, ctx, res);
+    FreeModCtx(ctx);
+    return code;
+}
@@ -0,0 +1,406 @@
+#include "limbs.h"
+#include <string.h>
+
+/*
+  Conversion between limbs and digit strings of bases 2..36.
+  Power-of-two bases are packed bit by bit in linear time. Other bases work on chunks of
+  chunk_digits digits that fit into one limb, long inputs are split in halves at a power
+  base^(chunk_digits * 2^i) from a table that is squared up once per conversion.
+  Digits are handed out most significant first through a sink, so nothing needs the whole string.
+*/
+
+#define MAX_POWERS 64
+
+static const char digit_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+struct radix {
+    limb_t base;
+    unsigned bits; //log2(base) for powers of two, 0 otherwise
+    size_t chunk_digits; //digits per limb
+    limb_t chunk_base; //base^chunk_digits
+};
+
+//powers[i] = chunk_base^(2^i), which covers digits[i] = chunk_digits * 2^i digits
+struct powers {
+    limb_t *limbs[MAX_POWERS];
+    size_t size[MAX_POWERS];
+    size_t digits[MAX_POWERS];
+    int count;
+};
+
+static void radix_init(struct radix *rd, int base) {
+    rd->base = (limb_t) base;
+    rd->bits = (base & (base - 1)) == 0 ? (unsigned) __builtin_ctz(base) : 0;
+    rd->chunk_digits = 0;
+    rd->chunk_base = 1;
+    while (rd->chunk_base <= ~(limb_t) 0 / rd->base) {
+        rd->chunk_base *= rd->base;
+        rd->chunk_digits++;
+    }
+}
+
+//normalized size that is 0 for zero
+static size_t trimmed_size(const limb_t *a, size_t n) {
+    n = limbs_normalized_size(a, n);
+    return n == 1 && a[0] == 0 ? 0 : n;
+}
+
+int limbs_digit_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 10;
+    return 36;
+}
+
+//base^(chunk_digits * k) >= 2^(64 * k), so a limb per chunk is always enough
+size_t limbs_size_for_digits(size_t len, int base) {
+    struct radix rd;
+    radix_init(&rd, base);
+    return (len + rd.chunk_digits - 1) / rd.chunk_digits;
+}
+
+//base^((chunk_digits + 1) * n) > 2^(64 * n)
+size_t limbs_digits_bound(size_t n, int base) {
+    struct radix rd;
+    radix_init(&rd, base);
+    return (rd.chunk_digits + 1) * (n == 0 ? 1 : n);
+}
+
+static void powers_free(struct powers *pw) {
+    for (int i = 0; i < pw->count; i++) {
+        scratch_free(pw->limbs[i]);
+    }
+}
+
+//squares the last power until the table has level + 1 entries, a failure leaves the table intact
+static int8_t powers_extend(struct powers *pw, int level) {
+    while (pw->count <= level && pw->count < MAX_POWERS) {
+        int i = pw->count - 1;
+        size_t n = pw->size[i];
+        limb_t *sqr = (limb_t *) scratch_alloc(sizeof(limb_t) * 2 * n);
+        if (sqr == NULL || limbs_mul(sqr, pw->limbs[i], n, pw->limbs[i], n) == ERROR) {
+            scratch_free(sqr);
+            return ERROR;
+        }
+        pw->limbs[i + 1] = sqr;
+        pw->size[i + 1] = limbs_normalized_size(sqr, 2 * n);
+        pw->digits[i + 1] = 2 * pw->digits[i];
+        pw->count++;
+    }
+    return pw->count > level ? SUCCESS : ERROR;
+}
+
+//squares until the next power would be longer than max_digits or wider than max_size limbs
+static int8_t powers_init(struct powers *pw, const struct radix *rd, size_t max_digits, size_t max_size) {
+    pw->limbs[0] = (limb_t *) scratch_alloc(sizeof(limb_t));
+    if (pw->limbs[0] == NULL) return ERROR;
+    pw->limbs[0][0] = rd->chunk_base;
+    pw->size[0] = 1;
+    pw->digits[0] = rd->chunk_digits;
+    pw->count = 1;
+    while (pw->count < MAX_POWERS && pw->digits[pw->count - 1] * 2 < max_digits &&
+           pw->size[pw->count - 1] * 2 - 1 <= max_size) {
+        if (powers_extend(pw, pw->count) == ERROR) {
+            powers_free(pw);
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+//Horner's scheme over whole chunks, returns the trimmed size
+static size_t from_str_basecase(limb_t *r, const char *str, size_t len, const struct radix *rd) {
+    size_t size = 0;
+    size_t chunk = len % rd->chunk_digits == 0 ? rd->chunk_digits : len % rd->chunk_digits;
+    for (const char *end = str + len; str < end; chunk = rd->chunk_digits) {
+        limb_t value = 0;
+        limb_t scale = 1;
+        for (size_t i = 0; i < chunk; i++) {
+            value = value * rd->base + (limb_t) limbs_digit_value(*str++);
+            scale *= rd->base;
+        }
+        limb_t carry = limbs_mul_1(r, r, size, scale, value);
+        if (carry != 0) r[size++] = carry;
+    }
+    return size;
+}
+
+static size_t from_str_pow2(limb_t *r, const char *str, size_t len, unsigned bits) {
+    size_t size = 0;
+    limb_t acc = 0;
+    unsigned filled = 0;
+    for (size_t i = len; i-- > 0;) {
+        limb_t digit = (limb_t) limbs_digit_value(str[i]);
+        acc |= digit << filled;
+        filled += bits;
+        if (filled >= LIMB_BITS) {
+            r[size++] = acc;
+            filled -= LIMB_BITS;
+            acc = filled != 0 ? digit >> (bits - filled) : 0;
+        }
+    }
+    if (filled != 0) r[size++] = acc;
+    return trimmed_size(r, size);
+}
+
+//r = high * pow + low with low < pow, r has room for hn + pn limbs and overlaps nothing
+static int8_t combine(limb_t *r, size_t *rn, const limb_t *high, size_t hn, const limb_t *pow, size_t pn,
+                      const limb_t *low, size_t ln) {
+    if (hn == 0) {
+        memcpy(r, low, sizeof(limb_t) * ln);
+        *rn = ln;
+        return SUCCESS;
+    }
+    if (limbs_mul(r, pow, pn, high, hn) == ERROR) return ERROR;
+    //low is never longer than the power and the sum never carries out
+    limbs_add(r, r, hn + pn, low, ln);
+    *rn = limbs_normalized_size(r, hn + pn);
+    return SUCCESS;
+}
+
+//the product goes through scratch because it may be one limb wider than r
+static int8_t from_str_dc(limb_t *r, size_t *rn, const char *str, size_t len, const struct radix *rd,
+                          const struct powers *pw) {
+    if (len <= threshold_values[THRESHOLD_SET_STR_DC] * rd->chunk_digits) {
+        *rn = from_str_basecase(r, str, len, rd);
+        return SUCCESS;
+    }
+    int i = pw->count - 1;
+    while (pw->digits[i] >= len) i--;
+    size_t low_len = pw->digits[i], high_len = len - low_len, pn = pw->size[i];
+    size_t high_cap = (high_len + rd->chunk_digits - 1) / rd->chunk_digits;
+    size_t low_cap = (low_len + rd->chunk_digits - 1) / rd->chunk_digits;
+    limb_t *tmp = (limb_t *) scratch_alloc(sizeof(limb_t) * (2 * high_cap + low_cap + pn));
+    if (tmp == NULL) return ERROR;
+    limb_t *high = tmp, *low = tmp + high_cap, *prod = low + low_cap;
+
+    size_t hn, ln;
+    int8_t code = from_str_dc(high, &hn, str, high_len, rd, pw);
+    if (code == SUCCESS) code = from_str_dc(low, &ln, str + high_len, low_len, rd, pw);
+    if (code == SUCCESS) code = combine(prod, rn, high, hn, pw->limbs[i], pn, low, ln);
+    if (code == SUCCESS) memcpy(r, prod, sizeof(limb_t) * *rn);
+    scratch_free(tmp);
+    return code;
+}
+
+//str holds len valid digits, r gets limbs_size_for_digits(len, base) limbs and *rn its trimmed size
+int8_t limbs_from_str(limb_t *r, size_t *rn, const char *str, size_t len, int base) {
+    struct radix rd;
+    radix_init(&rd, base);
+    if (rd.bits != 0) {
+        *rn = from_str_pow2(r, str, len, rd.bits);
+        return SUCCESS;
+    }
+    if (len <= threshold_values[THRESHOLD_SET_STR_DC] * rd.chunk_digits) {
+        *rn = from_str_basecase(r, str, len, &rd);
+        return SUCCESS;
+    }
+    struct powers pw;
+    if (powers_init(&pw, &rd, len, SIZE_MAX) == ERROR) return ERROR;
+    int8_t code = from_str_dc(r, rn, str, len, &rd, &pw);
+    powers_free(&pw);
+    return code;
+}
+
+static int8_t emit_zeros(struct digit_sink *sink, size_t count) {
+    static const char zeros[] = "0000000000000000000000000000000000000000000000000000000000000000";
+    while (count > 0) {
+        size_t len = count < sizeof(zeros) - 1 ? count : sizeof(zeros) - 1;
+        if (sink->write(sink, zeros, len) == ERROR) return ERROR;
+        count -= len;
+    }
+    return SUCCESS;
+}
+
+//digits of a padded with zeroes to min_len, they are produced backwards in scratch and then emitted
+static int8_t to_str_basecase(struct digit_sink *sink, const limb_t *a, size_t n, size_t min_len,
+                              const struct radix *rd) {
+    size_t max_digits = (rd->chunk_digits + 1) * (n == 0 ? 1 : n);
+    limb_t *tmp = (limb_t *) scratch_alloc(sizeof(limb_t) * (n + 1) + max_digits);
+    if (tmp == NULL) return ERROR;
+    if (n != 0) memcpy(tmp, a, sizeof(limb_t) * n);
+    char *end = (char *) (tmp + n + 1) + max_digits;
+    char *cur = end;
+    while (n > 0) {
+        limb_t chunk = limbs_divmod_1(tmp, tmp, n, rd->chunk_base);
+        n = trimmed_size(tmp, n);
+        for (size_t i = 0; i < rd->chunk_digits && (n != 0 || chunk != 0); i++) {
+            *--cur = digit_chars[chunk % rd->base];
+            chunk /= rd->base;
+        }
+    }
+    size_t len = end - cur;
+    int8_t code = emit_zeros(sink, min_len > len ? min_len - len : 0);
+    if (code == SUCCESS && len != 0) code = sink->write(sink, cur, len);
+    scratch_free(tmp);
+    return code;
+}
+
+static int8_t to_str_pow2(struct digit_sink *sink, const limb_t *a, size_t n, unsigned bits) {
+    if (n == 0) return sink->write(sink, "0", 1);
+    char buf[256];
+    size_t len = 0;
+    size_t total = (n - 1) * LIMB_BITS + LIMB_BITS - __builtin_clzll(a[n - 1]);
+    limb_t mask = ((limb_t) 1 << bits) - 1;
+    for (size_t j = (total + bits - 1) / bits; j-- > 0;) {
+        size_t pos = j * bits, limb = pos / LIMB_BITS;
+        unsigned off = pos % LIMB_BITS;
+        limb_t digit = a[limb] >> off;
+        if (off + bits > LIMB_BITS && limb + 1 < n) digit |= a[limb + 1] << (LIMB_BITS - off);
+        buf[len++] = digit_chars[digit & mask];
+        if (len == sizeof(buf) || j == 0) {
+            if (sink->write(sink, buf, len) == ERROR) return ERROR;
+            len = 0;
+        }
+    }
+    return SUCCESS;
+}
+
+//the quotient by the chosen power is never zero, so only the low half needs leading zeroes
+static int8_t to_str_dc(struct digit_sink *sink, const limb_t *a, size_t n, size_t min_len,
+                        const struct radix *rd, const struct powers *pw) {
+    n = trimmed_size(a, n);
+    if (n < threshold_values[THRESHOLD_GET_STR_DC]) return to_str_basecase(sink, a, n, min_len, rd);
+    int i = pw->count - 1;
+    while (i > 0 && 2 * pw->size[i] - 1 > n) i--;
+    size_t pn = pw->size[i], qn = n - pn + 1;
+    limb_t *tmp = (limb_t *) scratch_alloc(sizeof(limb_t) * (n + 1));
+    if (tmp == NULL) return ERROR;
+    limb_t *q = tmp, *r = tmp + qn;
+    size_t high_min = min_len > pw->digits[i] ? min_len - pw->digits[i] : 0;
+    int8_t code = limbs_divmod(q, r, a, n, pw->limbs[i], pn);
+    if (code == SUCCESS) code = to_str_dc(sink, q, qn, high_min, rd, pw);
+    if (code == SUCCESS) code = to_str_dc(sink, r, pn, pw->digits[i], rd, pw);
+    scratch_free(tmp);
+    return code;
+}
+
+//at most limbs_digits_bound(n, base) digits, most significant first
+int8_t limbs_to_str(struct digit_sink *sink, const limb_t *a, size_t n, int base) {
+    struct radix rd;
+    radix_init(&rd, base);
+    n = trimmed_size(a, n);
+    if (rd.bits != 0) return to_str_pow2(sink, a, n, rd.bits);
+    if (n < threshold_values[THRESHOLD_GET_STR_DC]) return to_str_basecase(sink, a, n, 1, &rd);
+    struct powers pw;
+    if (powers_init(&pw, &rd, SIZE_MAX, (n + 1) / 2) == ERROR) return ERROR;
+    int8_t code = to_str_dc(sink, a, n, 1, &rd, &pw);
+    powers_free(&pw);
+    return code;
+}
+
+/*
+  Streamed input is parsed in blocks of chunk_digits * 2^STREAM_BLOCK_LEVEL digits.
+  Blocks of equal length are merged pairwise like the carries of a binary counter,
+  so the digit text is never held in full and the merges form the same balanced tree
+  as the divide and conquer parse.
+*/
+#define STREAM_BLOCK_LEVEL 10
+
+struct block {
+    limb_t *limbs;
+    size_t size;
+    int level; //covers chunk_digits * 2^level digits
+};
+
+//len digits, at most a block of them
+static int8_t parse_block(struct block *b, const char *str, size_t len, const struct radix *rd,
+                          const struct powers *pw) {
+    b->limbs = (limb_t *) scratch_alloc(sizeof(limb_t) * (limbs_size_for_digits(len, (int) rd->base) + 1));
+    if (b->limbs == NULL) return ERROR;
+    return from_str_dc(b->limbs, &b->size, str, len, rd, pw);
+}
+
+//high = high * pow + low, low is released
+static int8_t merge(struct block *high, struct block *low, const limb_t *pow, size_t pn) {
+    limb_t *r = (limb_t *) scratch_alloc(sizeof(limb_t) * (high->size + pn + 1));
+    if (r == NULL || combine(r, &high->size, high->limbs, high->size, pow, pn, low->limbs, low->size) == ERROR) {
+        scratch_free(r);
+        return ERROR;
+    }
+    scratch_free(high->limbs);
+    scratch_free(low->limbs);
+    high->limbs = r;
+    low->limbs = NULL;
+    return SUCCESS;
+}
+
+//base^len for len below a block, as a product of table entries and one limb
+static int8_t small_power(struct block *p, size_t len, const struct radix *rd, const struct powers *pw) {
+    p->limbs = (limb_t *) scratch_alloc(sizeof(limb_t) * (limbs_size_for_digits(len, (int) rd->base) + 2));
+    if (p->limbs == NULL) return ERROR;
+    p->limbs[0] = 1;
+    for (size_t i = 0; i < len % rd->chunk_digits; i++) {
+        p->limbs[0] *= rd->base;
+    }
+    p->size = 1;
+    size_t chunks = len / rd->chunk_digits;
+    for (int i = 0; chunks != 0; i++, chunks >>= 1) {
+        if ((chunks & 1) == 0) continue;
+        struct block zero = {NULL, 0, 0};
+        if (merge(p, &zero, pw->limbs[i], pw->size[i]) == ERROR) return ERROR;
+    }
+    return SUCCESS;
+}
+
+//digits come from source until it runs dry, *r is allocated with scratch_alloc
+int8_t limbs_from_source(limb_t **r, size_t *rn, struct digit_source *source, int base) {
+    struct radix rd;
+    radix_init(&rd, base);
+    size_t block_digits = rd.chunk_digits << STREAM_BLOCK_LEVEL;
+    struct block stack[MAX_POWERS + 1], last = {NULL, 0, 0}, power = {NULL, 0, 0};
+    int depth = 0;
+    struct powers pw;
+    char *buf = (char *) scratch_alloc(block_digits);
+    if (buf == NULL || powers_init(&pw, &rd, block_digits, SIZE_MAX) == ERROR) {
+        scratch_free(buf);
+        return ERROR;
+    }
+
+    int8_t code = SUCCESS;
+    size_t len = 0;
+    while (code == SUCCESS) {
+        len = source->read(source, buf, block_digits);
+        if (source->code == ERROR) code = ERROR;
+        if (code == ERROR || len < block_digits) break;
+        code = parse_block(&stack[depth], buf, len, &rd, &pw);
+        stack[depth++].level = STREAM_BLOCK_LEVEL;
+        while (code == SUCCESS && depth >= 2 && stack[depth - 1].level == stack[depth - 2].level) {
+            int level = stack[depth - 1].level;
+            code = powers_extend(&pw, level);
+            if (code == SUCCESS) code = merge(&stack[depth - 2], &stack[depth - 1], pw.limbs[level], pw.size[level]);
+            if (code == ERROR) break;
+            depth--;
+            stack[depth - 1].level++;
+        }
+    }
+
+    //the partial block is the least significant one, everything above it is folded from the top down
+    if (code == SUCCESS) code = parse_block(&last, buf, len, &rd, &pw);
+    for (int i = 1; i < depth && code == SUCCESS; i++) {
+        code = powers_extend(&pw, stack[i].level);
+        if (code == SUCCESS) code = merge(&stack[0], &stack[i], pw.limbs[stack[i].level], pw.size[stack[i].level]);
+    }
+    if (code == SUCCESS && depth != 0) {
+        code = small_power(&power, len, &rd, &pw);
+        if (code == SUCCESS) code = merge(&stack[0], &last, power.limbs, power.size);
+    }
+    if (code == SUCCESS) {
+        if (depth == 0) {
+            stack[0] = last;
+            last.limbs = NULL;
+        }
+        *r = stack[0].limbs;
+        *rn = stack[0].size;
+        stack[0].limbs = NULL;
+    }
+
+    for (int i = 0; i < depth; i++) {
+        scratch_free(stack[i].limbs);
+    }
+    scratch_free(last.limbs);
+    scratch_free(power.limbs);
+    scratch_free(buf);
+    powers_free(&pw);
+    return code;
+}
@@ -0,0 +1,111 @@
+#include "number.h"
+#include "limbs.h"
+#include <string.h>
+
+/*
+  Binary format, all fields little-endian:
+  bytes 0..4   magic "BNUM"
+  byte  4      format version
+  byte  5      1 for negative numbers, 0 otherwise
+  bytes 6..8   reserved, zero
+  bytes 8..16  limb count
+  then the limbs, least significant first, 8 bytes each
+*/
+
+#define SERIAL_MAGIC "BNUM"
+#define SERIAL_VERSION 1
+#define SERIAL_HEADER_SIZE 16
+
+static const bool little_endian_host = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+static void store_le64(unsigned char *out, uint64_t x) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (unsigned char) (x >> (8 * i));
+    }
+}
+
+static uint64_t load_le64(const unsigned char *in) {
+    uint64_t x = 0;
+    for (int i = 0; i < 8; i++) {
+        x |= (uint64_t) in[i] << (8 * i);
+    }
+    return x;
+}
+
+size_t SerializedSize(BigNum num) {
+    return SERIAL_HEADER_SIZE + sizeof(limb_t) * num->size_;
+}
+
+int8_t SerializeNum(BigNum num, void *out, size_t cap, size_t *len) {
+    if (num == NULL || out == NULL || len == NULL || cap < SerializedSize(num)) return ERROR;
+    unsigned char *bytes = (unsigned char *) out;
+    memcpy(bytes, SERIAL_MAGIC, 4);
+    bytes[4] = SERIAL_VERSION;
+    bytes[5] = num->sign_ == -1;
+    bytes[6] = bytes[7] = 0;
+    store_le64(bytes + 8, num->size_);
+    if (little_endian_host) {
+        if (num->size_ != 0) memcpy(bytes + SERIAL_HEADER_SIZE, num->limbs_, sizeof(limb_t) * num->size_);
+    } else {
+        for (size_t i = 0; i < num->size_; i++) {
+            store_le64(bytes + SERIAL_HEADER_SIZE + sizeof(limb_t) * i, num->limbs_[i]);
+        }
+    }
+    *len = SerializedSize(num);
+    return SUCCESS;
+}
+
+//checks the header and returns the significant limb count, ERROR leaves the outputs alone
+static int8_t parse_header(const void *data, size_t len, size_t *size, int *sign) {
+    const unsigned char *bytes = (const unsigned char *) data;
+    if (data == NULL || len < SERIAL_HEADER_SIZE || memcmp(bytes, SERIAL_MAGIC, 4) != 0 ||
+        bytes[4] != SERIAL_VERSION || bytes[5] > 1 || bytes[6] != 0 || bytes[7] != 0) {
+        return ERROR;
+    }
+    uint64_t count = load_le64(bytes + 8);
+    if (count > (len - SERIAL_HEADER_SIZE) / sizeof(limb_t)) return ERROR;
+    const unsigned char *limbs = bytes + SERIAL_HEADER_SIZE;
+    while (count > 0 && load_le64(limbs + sizeof(limb_t) * (count - 1)) == 0) {
+        count--;
+    }
+    *size = (size_t) count;
+    *sign = bytes[5] == 1 && count != 0 ? -1 : 1;
+    return SUCCESS;
+}
+
+int8_t DeserializeNum(BigNum target, const void *data, size_t len) {
+    size_t size;
+    int sign;
+    if (target == NULL || parse_header(data, len, &size, &sign) == ERROR) return ERROR;
+    //the old value is of no use, so nothing is copied when the storage grows
+    target->size_ = 0;
+    if (ReserveNum(target, size == 0 ? 1 : size) == ERROR) return ERROR;
+    const unsigned char *limbs = (const unsigned char *) data + SERIAL_HEADER_SIZE;
+    for (size_t i = 0; i < size; i++) {
+        target->limbs_[i] = load_le64(limbs + sizeof(limb_t) * i);
+    }
+    if (size == 0) target->limbs_[size++] = 0;
+    target->size_ = size;
+    target->sign_ = sign;
+    return SUCCESS;
+}
+
+int8_t ViewNum(BigNum view, const void *data, size_t len) {
+    size_t size;
+    int sign;
+    if (view == NULL || parse_header(data, len, &size, &sign) == ERROR) return ERROR;
+    const unsigned char *limbs = (const unsigned char *) data + SERIAL_HEADER_SIZE;
+    //zero is kept inline, everything else has to be readable in place
+    if (size != 0 && (!little_endian_host || (uintptr_t) limbs % _Alignof(limb_t) != 0)) return ERROR;
+    num_release_storage(view);
+    if (size == 0) {
+        view->limbs_[0] = 0;
+        view->size_ = 1;
+    } else {
+        view->limbs_ = (limb_t *) limbs;
+        view->size_ = size;
+        view->capacity_ = 0;
+    }
+    view->sign_ = sign;
+    return SUCCESS;
+}
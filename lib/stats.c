@@ -0,0 +1,160 @@
+#include "stats.h"
+#include <string.h>
+
+#ifdef NUM_STATS
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+  Every thread counts into a block of its own with relaxed loads and stores, which take no lock and no atomic
+  read-modify-write, and are still safe to read from the thread of a snapshot. The blocks are linked into
+  a registry that snapshots sum up, a finished thread adds its block to the retired totals.
+  A reset does not touch the counters, it records the current totals as the baseline of later snapshots.
+*/
+
+#define STAT_FIELDS (sizeof(struct NumStats) / sizeof(uint64_t))
+#define FIELD(member) (offsetof(struct NumStats, member) / sizeof(uint64_t))
+
+_Static_assert(sizeof(struct NumStats) % sizeof(uint64_t) == 0, "statistics must be a plain array of counters");
+
+struct stats_block {
+    union {
+        struct NumStats stats;
+        uint64_t fields[STAT_FIELDS];
+    } counts;
+    struct stats_block *prev, *next;
+};
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct stats_block *blocks = NULL;
+static uint64_t retired[STAT_FIELDS], baseline[STAT_FIELDS];
+static pthread_key_t exit_key;
+static pthread_once_t exit_key_once = PTHREAD_ONCE_INIT;
+
+static _Thread_local struct stats_block *own_block = NULL;
+static _Thread_local unsigned tier_depth = 0;
+
+static void retire_block(void *arg) {
+    struct stats_block *block = (struct stats_block *) arg;
+    pthread_mutex_lock(&registry_lock);
+    for (size_t i = 0; i < STAT_FIELDS; i++) {
+        retired[i] += block->counts.fields[i];
+    }
+    if (block->prev != NULL) {
+        block->prev->next = block->next;
+    } else {
+        blocks = block->next;
+    }
+    if (block->next != NULL) block->next->prev = block->prev;
+    pthread_mutex_unlock(&registry_lock);
+    free(block);
+}
+
+static void create_exit_key() {
+    pthread_key_create(&exit_key, retire_block);
+}
+
+//the block of the calling thread, registered on first use; plain malloc, the hooks are counted themselves
+static struct stats_block *thread_block() {
+    if (own_block != NULL) return own_block;
+    pthread_once(&exit_key_once, create_exit_key);
+    struct stats_block *block = (struct stats_block *) calloc(1, sizeof(struct stats_block));
+    if (block == NULL) return NULL;
+    pthread_mutex_lock(&registry_lock);
+    block->next = blocks;
+    if (blocks != NULL) blocks->prev = block;
+    blocks = block;
+    pthread_mutex_unlock(&registry_lock);
+    pthread_setspecific(exit_key, block);
+    own_block = block;
+    return block;
+}
+
+static void bump(size_t field, uint64_t amount) {
+    struct stats_block *block = thread_block();
+    if (block == NULL) return;
+    uint64_t *counter = &block->counts.fields[field];
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+static uint64_t now_ns() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000u + (uint64_t) t.tv_nsec;
+}
+
+static size_t size_bucket(size_t limbs) {
+    size_t bucket = limbs <= 1 ? 0 : LIMB_BITS - __builtin_clzll(limbs - 1);
+    return bucket < STAT_SIZE_BUCKETS ? bucket : STAT_SIZE_BUCKETS - 1;
+}
+
+void stats_call(enum StatOp op, size_t limbs) {
+    bump(FIELD(calls) + op, 1);
+    bump(FIELD(sizes) + op * STAT_SIZE_BUCKETS + size_bucket(limbs), 1);
+}
+
+uint64_t stats_enter(enum StatTier tier) {
+    bump(FIELD(tier_calls) + tier, 1);
+    return tier_depth++ == 0 ? now_ns() : 0;
+}
+
+void stats_leave(enum StatTier tier, uint64_t start) {
+    tier_depth--;
+    if (start != 0) bump(FIELD(tier_ns) + tier, now_ns() - start);
+}
+
+void stats_alloc(size_t bytes) {
+    bump(FIELD(allocations), 1);
+    bump(FIELD(bytes_allocated), bytes);
+}
+
+void stats_realloc(size_t bytes) {
+    bump(FIELD(reallocations), 1);
+    bump(FIELD(bytes_reallocated), bytes);
+}
+
+void stats_free() {
+    bump(FIELD(frees), 1);
+}
+
+//current totals, the lock is held
+static void sum_blocks(uint64_t *totals) {
+    memcpy(totals, retired, sizeof(retired));
+    for (struct stats_block *block = blocks; block != NULL; block = block->next) {
+        for (size_t i = 0; i < STAT_FIELDS; i++) {
+            totals[i] += __atomic_load_n(&block->counts.fields[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+int8_t GetNumStats(struct NumStats *stats) {
+    if (stats == NULL) return ERROR;
+    uint64_t totals[STAT_FIELDS];
+    pthread_mutex_lock(&registry_lock);
+    sum_blocks(totals);
+    for (size_t i = 0; i < STAT_FIELDS; i++) {
+        totals[i] -= baseline[i];
+    }
+    pthread_mutex_unlock(&registry_lock);
+    memcpy(stats, totals, sizeof(totals));
+    return SUCCESS;
+}
+
+void ResetNumStats() {
+    pthread_mutex_lock(&registry_lock);
+    sum_blocks(baseline);
+    pthread_mutex_unlock(&registry_lock);
+}
+
+#else
+
+int8_t GetNumStats(struct NumStats *stats) {
+    if (stats != NULL) memset(stats, 0, sizeof(struct NumStats));
+    return ERROR;
+}
+
+void ResetNumStats() {
+}
+
+#endif
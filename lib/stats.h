@@ -0,0 +1,48 @@
+#ifndef ARBITARYPRECISIONARITHMETICS_STATS_H
+#define ARBITARYPRECISIONARITHMETICS_STATS_H
+
+#include "number.h"
+
+/*
+  Hooks of the statistics layer, see stats.c; without NUM_STATS they compile to nothing.
+  STAT_TIMED evaluates a call under an algorithm tier and yields its result,
+  STAT_TIER_BEGIN and STAT_TIER_END bracket calls without one, once per block.
+*/
+
+#ifdef NUM_STATS
+void stats_call(enum StatOp op, size_t limbs);
+
+//start time if the thread is in no other tier, 0 otherwise
+uint64_t stats_enter(enum StatTier tier);
+
+void stats_leave(enum StatTier tier, uint64_t start);
+
+void stats_alloc(size_t bytes);
+
+void stats_realloc(size_t bytes);
+
+void stats_free();
+
+#define STAT_CALL(op, limbs) stats_call(op, limbs)
+#define STAT_TIMED(tier, call) ({ \
+    uint64_t stat_start_ = stats_enter(tier); \
+    __typeof__(call) stat_res_ = (call); \
+    stats_leave(tier, stat_start_); \
+    stat_res_; \
+})
+#define STAT_TIER_BEGIN(tier) uint64_t stat_start_ = stats_enter(tier)
+#define STAT_TIER_END(tier) stats_leave(tier, stat_start_)
+#define STAT_ALLOC(bytes) stats_alloc(bytes)
+#define STAT_REALLOC(bytes) stats_realloc(bytes)
+#define STAT_FREE() stats_free()
+#else
+#define STAT_CALL(op, limbs) ((void) 0)
+#define STAT_TIMED(tier, call) (call)
+#define STAT_TIER_BEGIN(tier) ((void) 0)
+#define STAT_TIER_END(tier) ((void) 0)
+#define STAT_ALLOC(bytes) ((void) 0)
+#define STAT_REALLOC(bytes) ((void) 0)
+#define STAT_FREE() ((void) 0)
+#endif
+
+#endif //ARBITARYPRECISIONARITHMETICS_STATS_H
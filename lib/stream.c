@@ -0,0 +1,169 @@
+#include "number.h"
+#include "limbs.h"
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+//characters come either from a FILE, which can take one back, or from a descriptor through a buffer
+#define FD_BUFFER_SIZE ((size_t) 64 * 1024)
+
+struct reader {
+    struct digit_source source;
+    FILE *stream;
+    int fd;
+    char *buf;
+    size_t pos;
+    size_t len;
+};
+
+static int reader_get(struct reader *reader) {
+    if (reader->stream != NULL) {
+        int c = getc(reader->stream);
+        if (c == EOF && ferror(reader->stream)) reader->source.code = ERROR;
+        return c;
+    }
+    if (reader->pos == reader->len) {
+        ssize_t got;
+        do {
+            got = read(reader->fd, reader->buf, FD_BUFFER_SIZE);
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0) {
+            if (got < 0) reader->source.code = ERROR;
+            return EOF;
+        }
+        reader->pos = 0;
+        reader->len = (size_t) got;
+    }
+    return (unsigned char) reader->buf[reader->pos++];
+}
+
+//only the character just read can be given back
+static void reader_unget(struct reader *reader, int c) {
+    if (c == EOF) return;
+    if (reader->stream != NULL) {
+        ungetc(c, reader->stream);
+    } else {
+        reader->pos--;
+    }
+}
+
+static size_t reader_read_digits(struct digit_source *source, char *buf, size_t cap) {
+    struct reader *reader = (struct reader *) source;
+    size_t len = 0;
+    while (len < cap) {
+        int c = reader_get(reader);
+        if (c < '0' || c > '9') {
+            reader_unget(reader, c);
+            break;
+        }
+        buf[len++] = (char) c;
+    }
+    return len;
+}
+
+static int8_t read_num(BigNum target, struct reader *reader) {
+    int c;
+    do {
+        c = reader_get(reader);
+    } while (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f');
+    int sign = 1;
+    if (c == '+' || c == '-') {
+        sign = c == '-' ? -1 : 1;
+        c = reader_get(reader);
+    }
+    if (c < '0' || c > '9') return ERROR;
+    while (c == '0') {
+        c = reader_get(reader);
+    }
+    reader_unget(reader, c);
+    if (reader->source.code == ERROR) return ERROR;
+
+    limb_t *limbs;
+    size_t size;
+    if (limbs_from_source(&limbs, &size, &reader->source, 10) == ERROR) return ERROR;
+    //the old value is of no use, so nothing is copied when the storage grows
+    target->size_ = 0;
+    int8_t code = ReserveNum(target, size == 0 ? 1 : size);
+    if (code == SUCCESS) {
+        if (size == 0) {
+            target->limbs_[0] = 0;
+            target->size_ = 1;
+            target->sign_ = 1;
+        } else {
+            memcpy(target->limbs_, limbs, sizeof(limb_t) * size);
+            target->size_ = size;
+            target->sign_ = sign;
+        }
+    }
+    scratch_free(limbs);
+    return code;
+}
+
+int8_t ReadNum(BigNum target, FILE *stream) {
+    if (target == NULL || stream == NULL) return ERROR;
+    struct reader reader = {{reader_read_digits, SUCCESS}, stream, -1, NULL, 0, 0};
+    return read_num(target, &reader);
+}
+
+int8_t ReadNumFd(BigNum target, int fd) {
+    if (target == NULL || fd < 0) return ERROR;
+    struct reader reader = {{reader_read_digits, SUCCESS}, NULL, fd, scratch_alloc(FD_BUFFER_SIZE), 0, 0};
+    if (reader.buf == NULL) return ERROR;
+    int8_t code = read_num(target, &reader);
+    scratch_free(reader.buf);
+    return code;
+}
+
+struct writer {
+    struct digit_sink sink;
+    FILE *stream;
+    int fd;
+    char *buf;
+    size_t len;
+};
+
+static int8_t writer_flush(struct writer *writer) {
+    for (size_t done = 0; done < writer->len;) {
+        ssize_t put = write(writer->fd, writer->buf + done, writer->len - done);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return ERROR;
+        done += (size_t) put;
+    }
+    writer->len = 0;
+    return SUCCESS;
+}
+
+static int8_t writer_write(struct digit_sink *sink, const char *digits, size_t len) {
+    struct writer *writer = (struct writer *) sink;
+    if (writer->stream != NULL) return fwrite(digits, 1, len, writer->stream) == len ? SUCCESS : ERROR;
+    while (len > 0) {
+        size_t part = FD_BUFFER_SIZE - writer->len < len ? FD_BUFFER_SIZE - writer->len : len;
+        memcpy(writer->buf + writer->len, digits, part);
+        writer->len += part;
+        digits += part;
+        len -= part;
+        if (writer->len == FD_BUFFER_SIZE && writer_flush(writer) == ERROR) return ERROR;
+    }
+    return SUCCESS;
+}
+
+static int8_t write_num(BigNum num, struct writer *writer) {
+    if (num->sign_ == -1 && writer_write(&writer->sink, "-", 1) == ERROR) return ERROR;
+    return limbs_to_str(&writer->sink, num->limbs_, num->size_, 10);
+}
+
+int8_t WriteNum(BigNum num, FILE *stream) {
+    if (num == NULL || stream == NULL) return ERROR;
+    struct writer writer = {{writer_write}, stream, -1, NULL, 0};
+    return write_num(num, &writer);
+}
+
+int8_t WriteNumFd(BigNum num, int fd) {
+    if (num == NULL || fd < 0) return ERROR;
+    struct writer writer = {{writer_write}, NULL, fd, scratch_alloc(FD_BUFFER_SIZE), 0};
+    if (writer.buf == NULL) return ERROR;
+    int8_t code = write_num(num, &writer);
+    if (code == SUCCESS) code = writer_flush(&writer);
+    scratch_free(writer.buf);
+    return code;
+}
@@ -0,0 +1,40 @@
+#include "limbs.h"
+#include "thresholds.h"
+
+size_t threshold_values[THRESHOLDS_COUNT] = {
+        [THRESHOLD_MUL_KARATSUBA] = MUL_KARATSUBA_THRESHOLD,
+        [THRESHOLD_MUL_TOOM3] = MUL_TOOM3_THRESHOLD,
+        [THRESHOLD_MUL_NTT] = MUL_NTT_THRESHOLD,
+        [THRESHOLD_SQR_KARATSUBA] = SQR_KARATSUBA_THRESHOLD,
+        [THRESHOLD_SQR_TOOM3] = SQR_TOOM3_THRESHOLD,
+        [THRESHOLD_SQR_NTT] = SQR_NTT_THRESHOLD,
+        [THRESHOLD_DIV_BZ] = DIV_BZ_THRESHOLD,
+        [THRESHOLD_HGCD] = HGCD_THRESHOLD,
+        [THRESHOLD_GET_STR_DC] = GET_STR_DC_THRESHOLD,
+        [THRESHOLD_SET_STR_DC] = SET_STR_DC_THRESHOLD,
+};
+
+//every algorithm needs at least a couple of limbs to split
+static const size_t min_threshold[THRESHOLDS_COUNT] = {
+        [THRESHOLD_MUL_KARATSUBA] = 2,
+        [THRESHOLD_MUL_TOOM3] = 3,
+        [THRESHOLD_MUL_NTT] = 1,
+        [THRESHOLD_SQR_KARATSUBA] = 2,
+        [THRESHOLD_SQR_TOOM3] = 3,
+        [THRESHOLD_SQR_NTT] = 1,
+        [THRESHOLD_DIV_BZ] = 4,
+        [THRESHOLD_HGCD] = 3,
+        [THRESHOLD_GET_STR_DC] = 2,
+        [THRESHOLD_SET_STR_DC] = 2,
+};
+
+int8_t SetThreshold(enum Threshold threshold, size_t limbs) {
+    if (threshold < 0 || threshold >= THRESHOLDS_COUNT || limbs < min_threshold[threshold]) return ERROR;
+    threshold_values[threshold] = limbs;
+    return SUCCESS;
+}
+
+size_t GetThreshold(enum Threshold threshold) {
+    if (threshold < 0 || threshold >= THRESHOLDS_COUNT) return 0;
+    return threshold_values[threshold];
+}
@@ -0,0 +1,51 @@
+#ifndef ARBITARYPRECISIONARITHMETICS_THRESHOLDS_H
+#define ARBITARYPRECISIONARITHMETICS_THRESHOLDS_H
+
+//default crossover points in limbs, can be overridden at compile time
+
+//a header written by tests/tune, see lib/CMakeLists.txt
+#ifdef TUNED_THRESHOLDS
+#include TUNED_THRESHOLDS
+#endif
+
+#ifndef MUL_KARATSUBA_THRESHOLD
+#define MUL_KARATSUBA_THRESHOLD 32
+#endif
+
+#ifndef MUL_TOOM3_THRESHOLD
+#define MUL_TOOM3_THRESHOLD 150
+#endif
+
+#ifndef MUL_NTT_THRESHOLD
+#define MUL_NTT_THRESHOLD 2000
+#endif
+
+#ifndef SQR_KARATSUBA_THRESHOLD
+#define SQR_KARATSUBA_THRESHOLD 100
+#endif
+
+#ifndef SQR_TOOM3_THRESHOLD
+#define SQR_TOOM3_THRESHOLD 220
+#endif
+
+#ifndef SQR_NTT_THRESHOLD
+#define SQR_NTT_THRESHOLD 6000
+#endif
+
+#ifndef DIV_BZ_THRESHOLD
+#define DIV_BZ_THRESHOLD 40
+#endif
+
+#ifndef HGCD_THRESHOLD
+#define HGCD_THRESHOLD 150
+#endif
+
+#ifndef GET_STR_DC_THRESHOLD
+#define GET_STR_DC_THRESHOLD 30
+#endif
+
+#ifndef SET_STR_DC_THRESHOLD
+#define SET_STR_DC_THRESHOLD 300
+#endif
+
+#endif //ARBITARYPRECISIONARITHMETICS_THRESHOLDS_H
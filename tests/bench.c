@@ -0,0 +1,214 @@
+#include <number.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Throughput of the public operations from 1 to 10^7 decimal digits, in balanced and unbalanced shapes.
+  Every point is run in batches that double until they take a tenth of the time budget, the fastest batch counts,
+  which keeps interrupts and other noise out. Results go to stdout as a table, as CSV or as JSON.
+  A full sweep takes a long while, GCD and DivMod of 10^7 digits dominate it.
+
+  usage: bench [--csv | --json] [--max-digits N] [--min-time MS] [--op NAME]...
+*/
+
+#define MAX_RATIOS 2
+#define MAX_OPS 16
+
+static uint64_t state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t random_limb() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static double seconds() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+//decimal digits without a leading zero
+static char *random_digits(size_t len) {
+    char *str = (char *) malloc(len + 1);
+    for (size_t i = 0; i < len; i++) {
+        str[i] = (char) ('0' + random_limb() % 10);
+    }
+    if (str[0] == '0') str[0] = '7';
+    str[len] = '\0';
+    return str;
+}
+
+struct operands {
+    BigNum lhs, rhs, res, rem;
+    const char *digits; //the digits of lhs
+};
+
+//lhs has the digits of the point, rhs those divided by a ratio, 0 for operations of one operand
+struct op {
+    const char *name;
+    size_t ratios[MAX_RATIOS];
+    int8_t (*run)(struct operands *x);
+};
+
+static int8_t run_add(struct operands *x) {
+    return Add(x->lhs, x->rhs, x->res);
+}
+
+static int8_t run_sub(struct operands *x) {
+    return Sub(x->lhs, x->rhs, x->res);
+}
+
+static int8_t run_mult(struct operands *x) {
+    return Mult(x->lhs, x->rhs, x->res);
+}
+
+static int8_t run_divmod(struct operands *x) {
+    return DivMod(x->lhs, x->rhs, x->res, x->rem);
+}
+
+static int8_t run_gcd(struct operands *x) {
+    return GCD(x->lhs, x->rhs, x->res);
+}
+
+static int8_t run_set_str(struct operands *x) {
+    return SetFromStr(x->res, x->digits);
+}
+
+static int8_t run_to_str(struct operands *x) {
+    char *str = ToStr(x->lhs);
+    free(str);
+    return str == NULL ? ERROR : SUCCESS;
+}
+
+static const struct op ops[] = {
+        {"Add", {1, 10}, run_add},
+        {"Sub", {1, 10}, run_sub},
+        {"Mult", {1, 10}, run_mult},
+        {"DivMod", {2, 10}, run_divmod},
+        {"GCD", {1, 10}, run_gcd},
+        {"SetFromStr", {0}, run_set_str},
+        {"ToStr", {0}, run_to_str},
+};
+
+#define OPS_COUNT (sizeof(ops) / sizeof(ops[0]))
+
+enum format {
+    FORMAT_TABLE,
+    FORMAT_CSV,
+    FORMAT_JSON
+};
+
+//fastest time of one operation in seconds, reps receives how many were run in all
+static double measure(const struct op *op, struct operands *x, double min_time, size_t *reps) {
+    double best = 0, total = 0;
+    size_t batch = 1;
+    *reps = 0;
+    while (total < min_time || *reps == 0) {
+        double start = seconds();
+        for (size_t i = 0; i < batch; i++) {
+            if (op->run(x) == ERROR) return -1;
+        }
+        double elapsed = seconds() - start;
+        if (*reps == 0 || elapsed / (double) batch < best) best = elapsed / (double) batch;
+        total += elapsed;
+        *reps += batch;
+        if (elapsed < min_time / 10) batch *= 2;
+    }
+    return best;
+}
+
+static void report(enum format format, bool first, const char *name, size_t lhs_digits, size_t rhs_digits,
+                   size_t reps, double time) {
+    double ns = time * 1e9, rate = (double) lhs_digits / time;
+    if (format == FORMAT_CSV) {
+        printf("%s,%zu,%zu,%zu,%.1f,%.0f\n", name, lhs_digits, rhs_digits, reps, ns, rate);
+    } else if (format == FORMAT_JSON) {
+        printf("%s\n  {\"op\": \"%s\", \"lhs_digits\": %zu, \"rhs_digits\": %zu, \"reps\": %zu, "
+               "\"ns_per_op\": %.1f, \"digits_per_s\": %.0f}", first ? "" : ",", name, lhs_digits, rhs_digits, reps,
+               ns, rate);
+    } else {
+        printf("%-10s %9zu %9zu %10zu %16.1f %14.4g\n", name, lhs_digits, rhs_digits, reps, ns, rate);
+    }
+    fflush(stdout);
+}
+
+static bool selected(const char *name, const char **only, size_t only_count) {
+    for (size_t i = 0; i < only_count; i++) {
+        if (strcmp(only[i], name) == 0) return true;
+    }
+    return only_count == 0;
+}
+
+int main(int argc, char **argv) {
+    enum format format = FORMAT_TABLE;
+    size_t max_digits = 10000000;
+    double min_time = 0.2;
+    const char *only[MAX_OPS];
+    size_t only_count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            format = FORMAT_JSON;
+        } else if (strcmp(argv[i], "--max-digits") == 0 && i + 1 < argc) {
+            max_digits = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time = strtod(argv[++i], NULL) / 1000;
+        } else if (strcmp(argv[i], "--op") == 0 && i + 1 < argc && only_count < MAX_OPS) {
+            only[only_count++] = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--csv | --json] [--max-digits N] [--min-time MS] [--op NAME]...\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (format == FORMAT_CSV) printf("op,lhs_digits,rhs_digits,reps,ns_per_op,digits_per_s\n");
+    if (format == FORMAT_JSON) printf("[");
+    if (format == FORMAT_TABLE) {
+        printf("%-10s %9s %9s %10s %16s %14s\n", "op", "lhs", "rhs", "reps", "ns/op", "digits/s");
+    }
+    struct operands x = {CreateNum(), CreateNum(), CreateNum(), CreateNum(), NULL};
+    bool first = true, ok = true;
+    //1, 3, 10, 30, ... digits
+    for (size_t digits = 1; digits <= max_digits; digits = digits % 3 == 0 ? digits / 3 * 10 : digits * 3) {
+        char *lhs_digits = random_digits(digits);
+        SetFromStr(x.lhs, lhs_digits);
+        x.digits = lhs_digits;
+        for (size_t i = 0; i < OPS_COUNT; i++) {
+            if (!selected(ops[i].name, only, only_count)) continue;
+            size_t last_len = 0;
+            for (size_t r = 0; r < MAX_RATIOS && (r == 0 || ops[i].ratios[r] != 0); r++) {
+                size_t ratio = ops[i].ratios[r];
+                size_t rhs_len = ratio == 0 ? 0 : digits / ratio > 0 ? digits / ratio : 1;
+                //small operands make the shapes coincide
+                if (r > 0 && rhs_len == last_len) continue;
+                last_len = rhs_len;
+                if (ratio != 0) {
+                    char *rhs_digits = random_digits(rhs_len);
+                    SetFromStr(x.rhs, rhs_digits);
+                    free(rhs_digits);
+                }
+                size_t reps;
+                double time = measure(&ops[i], &x, min_time, &reps);
+                if (time < 0) {
+                    fprintf(stderr, "%s failed at %zu digits\n", ops[i].name, digits);
+                    ok = false;
+                    continue;
+                }
+                report(format, first, ops[i].name, digits, rhs_len, reps, time);
+                first = false;
+            }
+        }
+        free(lhs_digits);
+    }
+    if (format == FORMAT_JSON) printf("\n]\n");
+    FreeNum(x.lhs);
+    FreeNum(x.rhs);
+    FreeNum(x.res);
+    FreeNum(x.rem);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+#include <number.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+/*
+  Timing-leak check in the style of dudect: every routine runs on inputs of two classes, fixed and random,
+  picked in random order, and Welch's t-test compares the timings of the classes. The test is repeated on the
+  measurements below several percentiles, which removes interrupts and other noise from the upper tail.
+  |t| above 10 means the routine is not constant time. The variable-time PowMod is measured as a control.
+
+  usage: dudect [measurements per routine]
+*/
+
+#define LEAK_T 10.0
+#define WIDTH 32
+#define CROPS 5
+#define BATCH 256
+
+static const double crop_percentiles[CROPS] = {1.0, 0.99, 0.9, 0.75, 0.5};
+
+static uint64_t state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t random_limb() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static uint64_t ticks() {
+#if defined(__x86_64__)
+    unsigned aux;
+    return __rdtscp(&aux);
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000u + t.tv_nsec;
+#endif
+}
+
+struct welch {
+    double n[2], mean[2], m2[2];
+};
+
+static void welch_push(struct welch *w, int cls, double x) {
+    w->n[cls]++;
+    double delta = x - w->mean[cls];
+    w->mean[cls] += delta / w->n[cls];
+    w->m2[cls] += delta * (x - w->mean[cls]);
+}
+
+static double welch_t(const struct welch *w) {
+    if (w->n[0] < 2 || w->n[1] < 2) return 0;
+    double v0 = w->m2[0] / (w->n[0] - 1), v1 = w->m2[1] / (w->n[1] - 1);
+    return (w->mean[0] - w->mean[1]) / sqrt(v0 / w->n[0] + v1 / w->n[1]);
+}
+
+//prepare fills the input slot of one measurement with operands of a class, run works on such a slot
+struct target {
+    const char *name;
+    size_t input_limbs;
+    void (*prepare)(int cls, limb_t *in);
+    void (*run)(limb_t *in);
+    bool constant_time;
+};
+
+static limb_t fixed[WIDTH], out[2 * WIDTH];
+static ModCtx ctx;
+static BigNum num_base, num_exp, num_res;
+
+static void fill_random(limb_t *x, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] = random_limb();
+    }
+}
+
+//the fixed class is one random value, chosen once
+static void fill_class(limb_t *x, int cls) {
+    if (cls == 0) {
+        memcpy(x, fixed, sizeof(fixed));
+    } else {
+        fill_random(x, WIDTH);
+    }
+}
+
+static void prepare_compare(int cls, limb_t *in) {
+    fill_random(in, WIDTH);
+    memcpy(in + WIDTH, in, sizeof(limb_t) * WIDTH);
+    if (cls == 1) in[WIDTH + random_limb() % WIDTH] ^= 1;
+}
+
+static void run_compare(limb_t *in) {
+    out[0] = (limb_t) CtCompare(in, in + WIDTH, WIDTH);
+}
+
+static void prepare_operands(int cls, limb_t *in) {
+    fill_class(in, cls);
+    fill_random(in + WIDTH, WIDTH);
+}
+
+static void run_add(limb_t *in) {
+    out[0] = CtAdd(out, in, in + WIDTH, WIDTH);
+}
+
+static void run_mult(limb_t *in) {
+    CtMult(out, in, in + WIDTH, WIDTH);
+}
+
+static void prepare_swap(int cls, limb_t *in) {
+    fill_random(in, 2 * WIDTH);
+    in[2 * WIDTH] = (limb_t) cls;
+}
+
+static void run_swap(limb_t *in) {
+    CtSwap(in, in + WIDTH, WIDTH, in[2 * WIDTH]);
+}
+
+static void prepare_pow(int cls, limb_t *in) {
+    fill_random(in, WIDTH);
+    fill_class(in + WIDTH, cls);
+}
+
+static void run_ct_pow(limb_t *in) {
+    CtPowMod(out, in, in + WIDTH, WIDTH, ctx);
+}
+
+//the control compares random exponents with a short one, which sliding windows get through much faster
+static void prepare_num_pow(int cls, limb_t *in) {
+    fill_random(in, 2 * WIDTH);
+    if (cls == 0) memset(in + WIDTH + 1, 0, sizeof(limb_t) * (WIDTH - 1));
+}
+
+static void run_num_pow(limb_t *in) {
+    CtToNum(num_base, in, WIDTH);
+    CtToNum(num_exp, in + WIDTH, WIDTH);
+    PowModCtx(num_base, num_exp, ctx, num_res);
+}
+
+static int compare_times(const void *x, const void *y) {
+    double dx = *(const double *) x, dy = *(const double *) y;
+    return (dx > dy) - (dx < dy);
+}
+
+static bool measure(const struct target *target, size_t count) {
+    int *classes = (int *) malloc(sizeof(int) * count);
+    double *times = (double *) malloc(sizeof(double) * count);
+    limb_t *inputs = (limb_t *) malloc(sizeof(limb_t) * BATCH * target->input_limbs);
+    //inputs are prepared a batch ahead, so that preparing them does not disturb the timings
+    for (size_t done = 0; done < count; done += BATCH) {
+        size_t batch = count - done < BATCH ? count - done : BATCH;
+        for (size_t i = 0; i < batch; i++) {
+            classes[done + i] = (int) (random_limb() & 1);
+            target->prepare(classes[done + i], inputs + i * target->input_limbs);
+        }
+        for (size_t i = 0; i < batch; i++) {
+            uint64_t start = ticks();
+            target->run(inputs + i * target->input_limbs);
+            times[done + i] = (double) (ticks() - start);
+        }
+    }
+
+    //the first tenth warms up caches and branch predictors and sets the crop limits
+    size_t warmup = count / 10;
+    double *sorted = (double *) malloc(sizeof(double) * warmup);
+    memcpy(sorted, times, sizeof(double) * warmup);
+    qsort(sorted, warmup, sizeof(double), compare_times);
+    struct welch tests[CROPS] = {0};
+    double limits[CROPS];
+    for (int c = 0; c < CROPS; c++) {
+        limits[c] = crop_percentiles[c] >= 1.0 ? INFINITY : sorted[(size_t) (crop_percentiles[c] * (warmup - 1))];
+    }
+    for (size_t i = warmup; i < count; i++) {
+        for (int c = 0; c < CROPS; c++) {
+            if (times[i] <= limits[c]) welch_push(&tests[c], classes[i], times[i]);
+        }
+    }
+    double max_t = 0;
+    for (int c = 0; c < CROPS; c++) {
+        double t = fabs(welch_t(&tests[c]));
+        if (t > max_t) max_t = t;
+    }
+    bool leaks = max_t > LEAK_T;
+    printf("%-10s max |t| = %8.2f  %s%s\n", target->name, max_t, leaks ? "LEAKS" : "ok",
+           target->constant_time ? "" : " (variable-time control)");
+    free(classes);
+    free(times);
+    free(inputs);
+    free(sorted);
+    return !leaks || !target->constant_time;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoull(argv[1], NULL, 10) : 100000;
+    if (count < 100) count = 100;
+
+    num_base = CreateNum();
+    num_exp = CreateNum();
+    num_res = CreateNum();
+    BigNum num_mod = CreateNum();
+    limb_t mod[WIDTH];
+    fill_random(mod, WIDTH);
+    mod[0] |= 1;
+    mod[WIDTH - 1] |= (limb_t) 1 << (LIMB_BITS - 1);
+    CtToNum(num_mod, mod, WIDTH);
+    ctx = CreateModCtx(num_mod);
+    FreeNum(num_mod);
+    fill_random(fixed, WIDTH);
+
+    const struct target targets[] = {
+            {"CtCompare", 2 * WIDTH, prepare_compare, run_compare, true},
+            {"CtAdd", 2 * WIDTH, prepare_operands, run_add, true},
+            {"CtMult", 2 * WIDTH, prepare_operands, run_mult, true},
+            {"CtSwap", 2 * WIDTH + 1, prepare_swap, run_swap, true},
+            {"CtPowMod", 2 * WIDTH, prepare_pow, run_ct_pow, true},
+            {"PowMod", 2 * WIDTH, prepare_num_pow, run_num_pow, false},
+    };
+    bool ok = true;
+    for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+        //exponentiations take far longer, fewer of them are enough
+        size_t n = targets[i].run == run_ct_pow || targets[i].run == run_num_pow ? count / 100 + 100 : count;
+        ok &= measure(&targets[i], n);
+    }
+    FreeModCtx(ctx);
+    FreeNum(num_base);
+    FreeNum(num_exp);
+    FreeNum(num_res);
+    return ok ? 0 : 1;
+}
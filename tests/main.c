@@ -1,5 +1,8 @@
 #include <number.h>
+#include <limbs.h>
+#include <fixed.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include "minunit.h"
 #include <string.h>
 
@@ -92,6 +95,10 @@ MU_TEST(addition) {
     test_operation("123", "122", "245", Add);
     test_operation("64446", "595", "65041", Add);
     test_operation("11", "-12", "-1", Add);
+    test_operation("18446744073709551615", "1", "18446744073709551616", Add);
+    test_operation("-18446744073709551616", "1", "-18446744073709551615", Add);
+    test_operation("340282366920938463463374607431768211455", "340282366920938463463374607431768211455",
+                   "680564733841876926926749214863536422910", Add);
 }
 
 MU_TEST(subtraction) {
@@ -151,6 +158,37 @@ MU_TEST(rep_arguments) {
                        "60111615093368812014982001639704895816094113169206648301063029");
 }
 
+MU_TEST(in_place) {
+    BigNum acc = CreateNum();
+    BigNum x = CreateNum();
+    BigNum expected = CreateNum();
+    mu_check(SetFromStr(acc, "-18446744073709551616") == SUCCESS);
+    mu_check(SetFromStr(x, "123456789123456789") == SUCCESS);
+    mu_check(ReserveNum(acc, 4) == SUCCESS);
+    limb_t *storage = acc->limbs_;
+    for (int i = 0; i < 1000; i++) {
+        mu_check(AddInPlace(acc, x) == SUCCESS);
+    }
+    mu_check(SubInPlace(acc, x) == SUCCESS);
+    mu_check(acc->limbs_ == storage);
+    mu_check(SetFromStr(expected, "104886588260623780595") == SUCCESS);
+    mu_check(Compare(acc, expected) == 0);
+
+    mu_check(MultInPlace(acc, acc) == SUCCESS);
+    mu_check(SetFromStr(expected, "11001196396953622264465074731630698554025") == SUCCESS);
+    mu_check(Compare(acc, expected) == 0);
+
+    mu_check(DivMod(acc, x, acc, x) == SUCCESS);
+    mu_check(SetFromStr(expected, "89109691537112842603679") == SUCCESS);
+    mu_check(Compare(acc, expected) == 0);
+    mu_check(SetFromStr(expected, "39926387089627294") == SUCCESS);
+    mu_check(Compare(x, expected) == 0);
+    mu_check(DivMod(acc, x, acc, acc) == ERROR);
+    FreeNum(acc);
+    FreeNum(x);
+    FreeNum(expected);
+}
+
 MU_TEST(multiplication) {
     test_operation("9139231024", "1", "9139231024", Mult);
     test_operation("251513513513511315135215154684614351213211132135151546854654654513212123121351",
@@ -164,6 +202,133 @@ MU_TEST(multiplication) {
                    Mult);
     test_operation("15151313131531554351", "0", "0", Mult);
     test_operation("0", "6546546546546854646464685", "0", Mult);
+    test_operation("18446744073709551615", "18446744073709551615", "340282366920938463426481119284349108225", Mult);
+    //a number that was never set counts as 0
+    BigNum unset = CreateNum(), x = CreateNum(), res = CreateNum();
+    mu_check(SetFromStr(x, "-123456789012345678901234567890") == SUCCESS);
+    mu_check(Mult(unset, x, res) == SUCCESS && res->size_ == 1 && res->limbs_[0] == 0 && res->sign_ == 1);
+    mu_check(Mult(x, unset, res) == SUCCESS && res->size_ == 1 && res->limbs_[0] == 0);
+    const BigNum lhs[2] = {x, unset}, rhs[2] = {unset, x};
+    BigNum out[2] = {res, CreateNum()};
+    mu_check(MultBatch(lhs, rhs, out, 2) == SUCCESS && out[1]->size_ == 1 && out[1]->limbs_[0] == 0);
+    mu_check(MultInPlace(x, unset) == SUCCESS && x->size_ == 1 && x->limbs_[0] == 0 && x->sign_ == 1);
+    FreeNum(out[1]);
+    FreeNum(unset);
+    FreeNum(x);
+    FreeNum(res);
+}
+
+//pseudo-random decimal string of the given length
+char *make_digits(size_t len, unsigned seed) {
+    char *str = (char *) malloc(len + 1);
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245u + 12345u;
+        str[i] = (char) ('0' + (seed >> 16) % 10);
+    }
+    str[0] = str[0] == '0' ? '7' : str[0];
+    str[len] = '\0';
+    return str;
+}
+
+void test_mult_algorithms(size_t lhs_len, size_t rhs_len) {
+    char *s_lhs = make_digits(lhs_len, lhs_len);
+    char *s_rhs = make_digits(rhs_len, rhs_len + 1);
+    BigNum lhs = CreateNum();
+    BigNum rhs = CreateNum();
+    BigNum expected = CreateNum();
+    BigNum res = CreateNum();
+    mu_check(SetFromStr(lhs, s_lhs) == SUCCESS);
+    mu_check(SetFromStr(rhs, s_rhs) == SUCCESS);
+    size_t karatsuba = GetThreshold(THRESHOLD_MUL_KARATSUBA);
+    size_t toom3 = GetThreshold(THRESHOLD_MUL_TOOM3);
+    size_t ntt = GetThreshold(THRESHOLD_MUL_NTT);
+
+    mu_check(SetThreshold(THRESHOLD_MUL_KARATSUBA, SIZE_MAX) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_NTT, SIZE_MAX) == SUCCESS);
+    mu_check(Mult(lhs, rhs, expected) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_KARATSUBA, 2) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_TOOM3, SIZE_MAX) == SUCCESS);
+    mu_check(Mult(lhs, rhs, res) == SUCCESS);
+    mu_check(Compare(res, expected) == 0);
+    mu_check(SetThreshold(THRESHOLD_MUL_TOOM3, 3) == SUCCESS);
+    mu_check(Mult(lhs, rhs, res) == SUCCESS);
+    mu_check(Compare(res, expected) == 0);
+    mu_check(SetThreshold(THRESHOLD_MUL_NTT, 1) == SUCCESS);
+    mu_check(Mult(lhs, rhs, res) == SUCCESS);
+    mu_check(Compare(res, expected) == 0);
+
+    mu_check(Mult(lhs, lhs, res) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_NTT, SIZE_MAX) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_KARATSUBA, SIZE_MAX) == SUCCESS);
+    mu_check(Mult(lhs, lhs, expected) == SUCCESS);
+    mu_check(Compare(res, expected) == 0);
+
+    mu_check(SetThreshold(THRESHOLD_MUL_KARATSUBA, karatsuba) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_TOOM3, toom3) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_NTT, ntt) == SUCCESS);
+    FreeNum(lhs);
+    FreeNum(rhs);
+    FreeNum(expected);
+    FreeNum(res);
+    free(s_lhs);
+    free(s_rhs);
+}
+
+//every squaring algorithm against a product of two distinct numbers
+void test_sqr_algorithms(size_t len) {
+    char *s_num = make_digits(len, len + 2);
+    BigNum num = CreateNum();
+    BigNum copy = CreateNum();
+    BigNum expected = CreateNum();
+    BigNum res = CreateNum();
+    mu_check(SetFromStr(num, s_num) == SUCCESS);
+    mu_check(CopyNum(num, copy) == SUCCESS);
+    mu_check(Mult(num, copy, expected) == SUCCESS);
+    size_t karatsuba = GetThreshold(THRESHOLD_SQR_KARATSUBA);
+    size_t toom3 = GetThreshold(THRESHOLD_SQR_TOOM3);
+    size_t ntt = GetThreshold(THRESHOLD_SQR_NTT);
+    size_t settings[4][3] = {{SIZE_MAX, SIZE_MAX, SIZE_MAX}, {2, SIZE_MAX, SIZE_MAX}, {2, 3, SIZE_MAX}, {2, 3, 1}};
+    for (int i = 0; i < 4; i++) {
+        mu_check(SetThreshold(THRESHOLD_SQR_KARATSUBA, settings[i][0]) == SUCCESS);
+        mu_check(SetThreshold(THRESHOLD_SQR_TOOM3, settings[i][1]) == SUCCESS);
+        mu_check(SetThreshold(THRESHOLD_SQR_NTT, settings[i][2]) == SUCCESS);
+        mu_check(Sqr(num, res) == SUCCESS);
+        mu_check(Compare(res, expected) == 0);
+    }
+    num->sign_ = -1;
+    mu_check(Mult(num, num, num) == SUCCESS);
+    mu_check(Compare(num, expected) == 0);
+
+    mu_check(SetThreshold(THRESHOLD_SQR_KARATSUBA, karatsuba) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_SQR_TOOM3, toom3) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_SQR_NTT, ntt) == SUCCESS);
+    FreeNum(num);
+    FreeNum(copy);
+    FreeNum(expected);
+    FreeNum(res);
+    free(s_num);
+}
+
+MU_TEST(mult_algorithms) {
+    test_mult_algorithms(40, 40);
+    test_mult_algorithms(1000, 1000);
+    test_mult_algorithms(3000, 2100);
+    test_mult_algorithms(5000, 700);
+    test_mult_algorithms(777, 20);
+    test_mult_algorithms(20000, 15000);
+    test_sqr_algorithms(1);
+    test_sqr_algorithms(45);
+    test_sqr_algorithms(1000);
+    test_sqr_algorithms(4321);
+    //the square of a number that was never set is 0, in place too
+    BigNum unset = CreateNum(), res = CreateNum();
+    mu_check(Sqr(unset, res) == SUCCESS && res->size_ == 1 && res->limbs_[0] == 0 && res->sign_ == 1);
+    mu_check(Sqr(unset, unset) == SUCCESS && unset->size_ == 1 && unset->limbs_[0] == 0);
+    FreeNum(unset);
+    FreeNum(res);
+    test_operation("-18446744073709551615", "-18446744073709551615", "340282366920938463426481119284349108225", Mult);
+    mu_check(SetThreshold(THRESHOLD_MUL_KARATSUBA, 1) == ERROR);
+    mu_check(SetThreshold(THRESHOLDS_COUNT, 100) == ERROR);
 }
 
 void test_compare(char const *s_lhs, char const *s_rhs, int8_t expected) {
@@ -176,6 +341,262 @@ void test_compare(char const *s_lhs, char const *s_rhs, int8_t expected) {
     FreeNum(rhs);
 }
 
+static size_t allocs_left;
+
+//fails once allocs_left allocations have been made
+static void *limited_malloc(size_t size) {
+    if (allocs_left == 0) return NULL;
+    allocs_left--;
+    return malloc(size);
+}
+
+void test_base_conversion(char const *given, int base, char const *decimal) {
+    BigNum num = CreateNum();
+    mu_check(SetFromStrBase(num, given, base) == SUCCESS);
+    char *str = ToStr(num);
+    mu_check(strcmp(str, decimal) == 0);
+    free(str);
+    FreeNum(num);
+}
+
+void test_radix_round_trip(size_t len) {
+    char *digits = make_digits(len, len);
+    BigNum num = CreateNum();
+    BigNum back = CreateNum();
+    mu_check(SetFromStr(num, digits) == SUCCESS);
+    char *str = ToStr(num);
+    mu_check(strcmp(str, digits) == 0);
+    free(str);
+    for (int base = 2; base <= 36; base += 7) {
+        str = ToStrBase(num, base);
+        mu_check(SetFromStrBase(back, str, base) == SUCCESS);
+        mu_check(Compare(num, back) == 0);
+        free(str);
+    }
+    free(digits);
+    FreeNum(num);
+    FreeNum(back);
+}
+
+MU_TEST(base_conversion) {
+    test_base_conversion("ff", 16, "255");
+    test_base_conversion("-Zz", 36, "-1295");
+    test_base_conversion("+000101", 2, "5");
+    test_base_conversion("10000000000000000000000000000000000000000000000000000000000000000", 2,
+                         "18446744073709551616");
+    test_base_conversion("-7fffffffffffffffffffffffffffffff", 16, "-170141183460469231731687303715884105727");
+    BigNum num = CreateNum();
+    mu_check(SetFromStrBase(num, "12", 2) == ERROR);
+    mu_check(SetFromStrBase(num, "12", 37) == ERROR);
+    mu_check(SetFromStrBase(num, "-1295", 10) == SUCCESS);
+    //a conversion that fails once the storage has grown leaves no size over lost limbs
+    char *digits = make_digits(5000, 5);
+    size_t dc_threshold = GetThreshold(THRESHOLD_SET_STR_DC);
+    SetThreshold(THRESHOLD_SET_STR_DC, 2);
+    allocs_left = 1;
+    SetAllocFunctions(limited_malloc, NULL, NULL);
+    mu_check(SetFromStrBase(num, digits, 10) == ERROR);
+    SetAllocFunctions(NULL, NULL, NULL);
+    SetThreshold(THRESHOLD_SET_STR_DC, dc_threshold);
+    mu_check(num->size_ == 0);
+    free(digits);
+    mu_check(SetFromStrBase(num, "-1295", 10) == SUCCESS);
+    char *str = ToStrBase(num, 36);
+    mu_check(strcmp(str, "-zz") == 0);
+    free(str);
+    mu_check(ToStrBase(num, 1) == NULL);
+    FreeNum(num);
+
+    size_t get_threshold = GetThreshold(THRESHOLD_GET_STR_DC), set_threshold = GetThreshold(THRESHOLD_SET_STR_DC);
+    SetThreshold(THRESHOLD_GET_STR_DC, 2);
+    SetThreshold(THRESHOLD_SET_STR_DC, 2);
+    test_radix_round_trip(1);
+    test_radix_round_trip(60);
+    test_radix_round_trip(777);
+    test_radix_round_trip(5000);
+    SetThreshold(THRESHOLD_GET_STR_DC, get_threshold);
+    SetThreshold(THRESHOLD_SET_STR_DC, set_threshold);
+    test_radix_round_trip(30000);
+}
+
+MU_TEST(buffers_and_streams) {
+    const char *text = "-123456789012345678901234567890 trailing";
+    BigNum num = CreateNum();
+    BigNum back = CreateNum();
+    mu_check(SetFromBuf(num, text, 31) == SUCCESS);
+    mu_check(SetFromBuf(back, text, 0) == ERROR);
+    char out[64];
+    size_t len;
+    mu_check(ToBuf(num, out, sizeof(out), &len) == SUCCESS);
+    mu_check(len == 31 && memcmp(out, text, len) == 0);
+    mu_check(ToBuf(num, out, 30, &len) == ERROR);
+
+    char *digits = make_digits(100000, 5);
+    mu_check(SetFromStr(num, digits) == SUCCESS);
+    FILE *file = tmpfile();
+    mu_check(file != NULL);
+    fputs("  ", file);
+    mu_check(WriteNum(num, file) == SUCCESS);
+    fputs(";", file);
+    rewind(file);
+    mu_check(ReadNum(back, file) == SUCCESS);
+    mu_check(getc(file) == ';');
+    mu_check(Compare(num, back) == 0);
+    fclose(file);
+
+    file = tmpfile();
+    mu_check(file != NULL);
+    mu_check(Mult(num, num, num) == SUCCESS);
+    mu_check(WriteNumFd(num, fileno(file)) == SUCCESS);
+    rewind(file);
+    mu_check(ReadNumFd(back, fileno(file)) == SUCCESS);
+    mu_check(Compare(num, back) == 0);
+    fclose(file);
+    free(digits);
+    FreeNum(num);
+    FreeNum(back);
+}
+
+MU_TEST(serialization) {
+    BigNum num = CreateNum();
+    BigNum back = CreateNum();
+    BigNum view = CreateNum();
+    limb_t data[64];
+    size_t len;
+    mu_check(SetFromStr(num, "-6277101735386680763835789423207666416102355444464034512896") == SUCCESS);
+    mu_check(SerializedSize(num) == 16 + 8 * 4);
+    mu_check(SerializeNum(num, data, 16 + 8 * 3, &len) == ERROR);
+    mu_check(SerializeNum(num, data, sizeof(data), &len) == SUCCESS);
+    mu_check(len == 48 && memcmp(data, "BNUM\x01\x01", 6) == 0);
+    mu_check(DeserializeNum(back, data, len) == SUCCESS);
+    mu_check(Compare(num, back) == 0);
+    mu_check(DeserializeNum(back, data, len - 1) == ERROR);
+
+    mu_check(ViewNum(view, data, len) == SUCCESS);
+    mu_check(view->limbs_ == data + 2);
+    mu_check(Compare(num, view) == 0);
+    mu_check(Add(view, view, back) == SUCCESS);
+    mu_check(AddInPlace(view, num) == SUCCESS);
+    mu_check(Compare(view, back) == 0);
+    mu_check(view->limbs_ != data + 2);
+    mu_check(DeserializeNum(back, data, len) == SUCCESS);
+    mu_check(Compare(num, back) == 0);
+
+    mu_check(SetFromStr(num, "0") == SUCCESS);
+    mu_check(SerializeNum(num, data, sizeof(data), &len) == SUCCESS);
+    mu_check(ViewNum(view, data, len) == SUCCESS);
+    mu_check(Compare(num, view) == 0);
+    FreeNum(num);
+    FreeNum(back);
+    FreeNum(view);
+}
+
+void test_pow_mod(char const *s_base, char const *s_exp, char const *s_mod, char const *expected) {
+    BigNum base = CreateNum();
+    BigNum exp = CreateNum();
+    BigNum mod = CreateNum();
+    BigNum res = CreateNum();
+    mu_check(SetFromStr(base, s_base) == SUCCESS);
+    mu_check(SetFromStr(exp, s_exp) == SUCCESS);
+    mu_check(SetFromStr(mod, s_mod) == SUCCESS);
+    mu_check(PowMod(base, exp, mod, res) == SUCCESS);
+    char *str = ToStr(res);
+    mu_check(strcmp(str, expected) == 0);
+    free(str);
+
+    ModCtx ctx = CreateModCtx(mod);
+    mu_check(ctx != NULL);
+    mu_check(PowModCtx(base, exp, ctx, base) == SUCCESS);
+    mu_check(Compare(base, res) == 0);
+    FreeModCtx(ctx);
+    FreeNum(base);
+    FreeNum(exp);
+    FreeNum(mod);
+    FreeNum(res);
+}
+
+MU_TEST(pow_mod) {
+    test_pow_mod("265613988875874769338781322035779626829233452653394495974574961739092490901302182994384699044001", "2582249878086908589655919172003011874329705792829223512830659356540647622016841194629645353280137831435903171972747505721", "6864797660130609714981900799081393217269435300143305409394463459185543183397656052122559640661454554977296311391480858037121987999716643812574028291115057151", "4680149201965475267823876251539177345172915238106912708131169426986779511981135548194700581915804336587031992923545266522661067848422890386986643760544418665");
+    test_pow_mod("-265613988875874769338781322035779626829233452653394495974574961739092490901302182994384699044001", "2582249878086908589655919172003011874329705792829223512830659356540647622016841194629645353280137831435903171972747505721", "115792089237316195423570985008687907853269984665640564039457584007913129639936000", "106132116601636430908380413064793960423028737279083238152811896057474346059643999");
+    test_pow_mod("-7", "3", "10", "7");
+    test_pow_mod("123456789", "65537", "170141183460469231731687303715884105727", "142853123101158166119999597599049700840");
+    test_pow_mod("5", "0", "1", "0");
+    test_pow_mod("5", "0", "-9", "1");
+    test_pow_mod("0", "0", "7", "1");
+    test_pow_mod("-265613988875874769338781322035779626829233452653394495974574961739092490901302182994384699044001", "1", "-6864797660130609714981900799081393217269435300143305409394463459185543183397656052122559640661454554977296311391480858037121987999716643812574028291115057151", "6864797660130609714981900799081393217269435300143305409394463193571554307522886713341237604881827725743843657996984883462160248907225742510391033906416013150");
+    BigNum num = CreateNum();
+    BigNum zero = CreateNum();
+    mu_check(SetFromStr(num, "-3") == SUCCESS);
+    mu_check(SetFromStr(zero, "0") == SUCCESS);
+    mu_check(PowMod(num, num, num, num) == ERROR);
+    mu_check(PowMod(num, zero, zero, num) == ERROR);
+    mu_check(CreateModCtx(zero) == NULL);
+    //numbers that were never set: no modulus, an exponent and a base of 0
+    BigNum unset = CreateNum(), res = CreateNum();
+    mu_check(CreateModCtx(unset) == NULL);
+    mu_check(PowMod(num, num, unset, res) == ERROR);
+    mu_check(SetFromStr(num, "7") == SUCCESS);
+    mu_check(PowMod(num, unset, num, res) == SUCCESS && res->size_ == 1 && res->limbs_[0] == 1);
+    mu_check(PowMod(unset, num, num, res) == SUCCESS && res->size_ == 1 && res->limbs_[0] == 0);
+    FreeNum(unset);
+    FreeNum(res);
+    FreeNum(num);
+    FreeNum(zero);
+}
+
+MU_TEST(constant_time) {
+    BigNum lhs = CreateNum();
+    BigNum rhs = CreateNum();
+    BigNum expected = CreateNum();
+    BigNum res = CreateNum();
+    limb_t a[8], b[8], r[16];
+    mu_check(SetFromStr(lhs, "340282366920938463463374607431768211455") == SUCCESS);
+    mu_check(SetFromStr(rhs, "-5") == SUCCESS);
+    mu_check(CtFromNum(a, 1, lhs) == ERROR);
+    mu_check(CtFromNum(a, 4, rhs) == ERROR);
+    rhs->sign_ = 1;
+    mu_check(CtFromNum(a, 4, lhs) == SUCCESS && CtFromNum(b, 4, rhs) == SUCCESS);
+    mu_check(CtCompare(a, b, 4) == 1 && CtCompare(b, a, 4) == -1 && CtCompare(a, a, 4) == 0);
+    mu_check(CtAdd(r, a, b, 4) == 0);
+    mu_check(CtToNum(res, r, 4) == SUCCESS);
+    mu_check(Add(lhs, rhs, expected) == SUCCESS && Compare(res, expected) == 0);
+    mu_check(CtSub(r, b, a, 4) == 1);
+    CtMult(r, a, b, 4);
+    mu_check(CtToNum(res, r, 8) == SUCCESS);
+    mu_check(Mult(lhs, rhs, expected) == SUCCESS && Compare(res, expected) == 0);
+    CtSwap(a, b, 4, 0);
+    mu_check(CtCompare(a, b, 4) == 1);
+    CtSwap(a, b, 4, 1);
+    mu_check(CtCompare(a, b, 4) == -1);
+
+    char *digits = make_digits(150, 3);
+    digits[149] = '7';
+    mu_check(SetFromStr(rhs, digits) == SUCCESS);
+    digits[20] = '\0';
+    mu_check(SetFromStr(lhs, digits + 5) == SUCCESS);
+    ModCtx ctx = CreateModCtx(rhs);
+    limb_t m[8], e[2];
+    mu_check(CtFromNum(b, rhs->size_, rhs) == SUCCESS && CtFromNum(e, 2, lhs) == SUCCESS);
+    for (size_t i = 0; i < rhs->size_; i++) {
+        a[i] = ~b[i];
+    }
+    mu_check(CtPowMod(m, a, e, 2, ctx) == SUCCESS);
+    mu_check(CtToNum(res, m, rhs->size_) == SUCCESS);
+    mu_check(CtToNum(expected, a, rhs->size_) == SUCCESS);
+    mu_check(PowMod(expected, lhs, rhs, expected) == SUCCESS);
+    mu_check(Compare(res, expected) == 0);
+    FreeModCtx(ctx);
+    mu_check(SetFromStr(rhs, "1000") == SUCCESS);
+    ctx = CreateModCtx(rhs);
+    mu_check(CtPowMod(m, a, e, 2, ctx) == ERROR);
+    FreeModCtx(ctx);
+    free(digits);
+    FreeNum(lhs);
+    FreeNum(rhs);
+    FreeNum(expected);
+    FreeNum(res);
+}
+
 MU_TEST(compare) {
     test_compare("100035151351351350", "100035151351351350", 0);
     test_compare("-11351351351355684654684", "-11351351351355684654684", 0);
@@ -245,6 +666,30 @@ void test_division(char const *s_lhs, char const *s_rhs) {
     FreeNum(abs_rhs);
 }
 
+//-(B^n - 1) and B^n in decimal
+static char *all_ones_negated(size_t n) {
+    BigNum num = CreateNum();
+    limb_t *limbs = (limb_t *) malloc(sizeof(limb_t) * n);
+    memset(limbs, 0xff, sizeof(limb_t) * n);
+    CtToNum(num, limbs, n);
+    num->sign_ = -1;
+    char *str = ToStr(num);
+    free(limbs);
+    FreeNum(num);
+    return str;
+}
+
+static char *power_of_limb_base(size_t n) {
+    BigNum num = CreateNum();
+    limb_t *limbs = (limb_t *) calloc(n + 1, sizeof(limb_t));
+    limbs[n] = 1;
+    CtToNum(num, limbs, n + 1);
+    char *str = ToStr(num);
+    free(limbs);
+    FreeNum(num);
+    return str;
+}
+
 MU_TEST(division) {
     test_division("54684684684684", "44646546464");
     test_division("5645465", "5415465465444665351325132135135465354365");
@@ -256,6 +701,40 @@ MU_TEST(division) {
     test_division("-878799959999455656", "54465656");
     test_division("-124865849848", "-16516546854685556565854");
     test_division("-546854685464", "5665");
+    test_division("-36893488147419103230", "18446744073709551615");
+    test_division("340282366920938463463374607431768211456", "-18446744073709551617");
+    //the floor of a negative dividend carries out of an all-ones quotient
+    test_division("-340282366920938463463374607431768211455", "18446744073709551616");
+    test_division("-340282366920938463463374607431768211455", "-18446744073709551616");
+    size_t bz = GetThreshold(THRESHOLD_DIV_BZ);
+    mu_check(SetThreshold(THRESHOLD_DIV_BZ, 4) == SUCCESS);
+    char *s_lhs = all_ones_negated(40), *s_rhs = power_of_limb_base(20);
+    test_division(s_lhs, s_rhs);
+    mu_check(SetThreshold(THRESHOLD_DIV_BZ, bz) == SUCCESS);
+    free(s_lhs);
+    free(s_rhs);
+}
+
+void test_division_algorithms(size_t lhs_len, size_t rhs_len) {
+    char *s_lhs = make_digits(lhs_len, lhs_len);
+    char *s_rhs = make_digits(rhs_len, rhs_len + 3);
+    size_t bz = GetThreshold(THRESHOLD_DIV_BZ);
+    test_division(s_lhs, s_rhs);
+    mu_check(SetThreshold(THRESHOLD_DIV_BZ, 4) == SUCCESS);
+    test_division(s_lhs, s_rhs);
+    s_lhs[0] = '-';
+    test_division(s_lhs, s_rhs);
+    mu_check(SetThreshold(THRESHOLD_DIV_BZ, bz) == SUCCESS);
+    free(s_lhs);
+    free(s_rhs);
+}
+
+MU_TEST(division_algorithms) {
+    test_division_algorithms(3000, 1500);
+    test_division_algorithms(5000, 700);
+    test_division_algorithms(2000, 1900);
+    test_division_algorithms(9000, 80);
+    test_division_algorithms(100, 100);
 }
 
 void test_gcd(char *s_lhs, char *s_rhs, char *expected) {
@@ -284,6 +763,823 @@ MU_TEST(gcd) {
     test_gcd("0", "0", "0");
     test_gcd("-5", "10", "5");
     test_gcd("5", "-10", "5");
+    //numbers that were never set count as 0
+    BigNum unset = CreateNum(), x = CreateNum(), g = CreateNum(), s = CreateNum(), t = CreateNum();
+    BigNum expect = CreateNum();
+    mu_check(SetFromStr(x, "-12") == SUCCESS && SetFromStr(expect, "12") == SUCCESS);
+    mu_check(GCD(unset, x, g) == SUCCESS && Compare(g, expect) == 0);
+    mu_check(GCD(x, unset, g) == SUCCESS && Compare(g, expect) == 0);
+    mu_check(ExtGCD(unset, x, g, s, t) == SUCCESS && Compare(g, expect) == 0);
+    mu_check(s->size_ == 1 && s->limbs_[0] == 0 && t->size_ == 1 && t->limbs_[0] == 1 && t->sign_ == -1);
+    mu_check(ExtGCD(x, unset, g, s, t) == SUCCESS && Compare(g, expect) == 0);
+    mu_check(s->size_ == 1 && s->limbs_[0] == 1 && s->sign_ == -1 && t->size_ == 1 && t->limbs_[0] == 0);
+    mu_check(GCD(unset, unset, g) == SUCCESS && g->size_ == 1 && g->limbs_[0] == 0);
+    FreeNum(unset);
+    FreeNum(x);
+    FreeNum(g);
+    FreeNum(s);
+    FreeNum(t);
+    FreeNum(expect);
+}
+
+//checks g = gcd(a, b) = s * a + t * b and |s| <= |b| / 2g
+void check_ext_gcd(BigNum a, BigNum b) {
+    BigNum g = CreateNum();
+    BigNum s = CreateNum();
+    BigNum t = CreateNum();
+    BigNum expect = CreateNum();
+    BigNum sum = CreateNum();
+    BigNum tmp = CreateNum();
+    mu_check(GCD(a, b, expect) == SUCCESS);
+    mu_check(ExtGCD(a, b, g, s, t) == SUCCESS);
+    mu_check(Compare(g, expect) == 0);
+    mu_check(Mult(s, a, sum) == SUCCESS);
+    mu_check(Mult(t, b, tmp) == SUCCESS);
+    mu_check(Add(sum, tmp, sum) == SUCCESS);
+    mu_check(Compare(sum, g) == 0);
+    if (!(b->size_ == 1 && b->limbs_[0] == 0)) {
+        mu_check(Abs(s, sum) == SUCCESS);
+        mu_check(Add(sum, sum, sum) == SUCCESS);
+        mu_check(Mult(sum, g, sum) == SUCCESS);
+        mu_check(Abs(b, tmp) == SUCCESS);
+        mu_check(Compare(sum, tmp) != 1);
+    }
+    FreeNum(g);
+    FreeNum(s);
+    FreeNum(t);
+    FreeNum(expect);
+    FreeNum(sum);
+    FreeNum(tmp);
+}
+
+void test_ext_gcd(char *s_a, char *s_b) {
+    BigNum a = CreateNum();
+    BigNum b = CreateNum();
+    SetFromStr(a, s_a);
+    SetFromStr(b, s_b);
+    check_ext_gcd(a, b);
+    FreeNum(a);
+    FreeNum(b);
+}
+
+//both numbers share the factor with digits of the given length, the gcd must not depend on the algorithm
+void test_gcd_algorithms(size_t a_len, size_t b_len, size_t common_len) {
+    char *s_a = make_digits(a_len, a_len);
+    char *s_b = make_digits(b_len, b_len + 5);
+    char *s_common = make_digits(common_len, common_len + 11);
+    BigNum a = CreateNum();
+    BigNum b = CreateNum();
+    BigNum common = CreateNum();
+    BigNum lehmer = CreateNum();
+    BigNum half = CreateNum();
+    SetFromStr(a, s_a);
+    SetFromStr(b, s_b);
+    SetFromStr(common, s_common);
+    mu_check(Mult(a, common, a) == SUCCESS);
+    mu_check(Mult(b, common, b) == SUCCESS);
+    size_t hgcd = GetThreshold(THRESHOLD_HGCD);
+    mu_check(SetThreshold(THRESHOLD_HGCD, SIZE_MAX) == SUCCESS);
+    mu_check(GCD(a, b, lehmer) == SUCCESS);
+    check_ext_gcd(a, b);
+    mu_check(SetThreshold(THRESHOLD_HGCD, 3) == SUCCESS);
+    mu_check(GCD(a, b, half) == SUCCESS);
+    check_ext_gcd(b, a);
+    mu_check(SetThreshold(THRESHOLD_HGCD, hgcd) == SUCCESS);
+    mu_check(Compare(lehmer, half) == 0);
+    mu_check(Mod(lehmer, common, half) == SUCCESS);
+    mu_check(half->size_ == 1 && half->limbs_[0] == 0);
+    FreeNum(a);
+    FreeNum(b);
+    FreeNum(common);
+    FreeNum(lehmer);
+    FreeNum(half);
+    free(s_a);
+    free(s_b);
+    free(s_common);
+}
+
+//operands of uniformly random limbs at the default threshold, where the half-GCD sees every sign of its cofactors
+void test_gcd_random(size_t an, size_t bn, uint64_t seed) {
+    limb_t *limbs = (limb_t *) malloc(sizeof(limb_t) * (an > bn ? an : bn));
+    BigNum a = CreateNum(), b = CreateNum(), lehmer = CreateNum(), half = CreateNum();
+    for (size_t i = 0; i < an; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        limbs[i] = seed ^ (seed >> 29);
+    }
+    CtToNum(a, limbs, an);
+    for (size_t i = 0; i < bn; i++) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        limbs[i] = seed ^ (seed >> 29);
+    }
+    CtToNum(b, limbs, bn);
+    size_t hgcd = GetThreshold(THRESHOLD_HGCD);
+    mu_check(SetThreshold(THRESHOLD_HGCD, SIZE_MAX) == SUCCESS);
+    mu_check(GCD(a, b, lehmer) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_HGCD, hgcd) == SUCCESS);
+    mu_check(GCD(a, b, half) == SUCCESS);
+    mu_check(Compare(lehmer, half) == 0);
+    check_ext_gcd(a, b);
+    FreeNum(a);
+    FreeNum(b);
+    FreeNum(lehmer);
+    FreeNum(half);
+    free(limbs);
+}
+
+MU_TEST(ext_gcd) {
+    test_ext_gcd("240", "46");
+    test_ext_gcd("46", "240");
+    test_ext_gcd("-240", "46");
+    test_ext_gcd("240", "-46");
+    test_ext_gcd("17", "17");
+    test_ext_gcd("0", "5");
+    test_ext_gcd("-5", "0");
+    test_ext_gcd("0", "0");
+    test_ext_gcd("1", "340282366920938463463374607431768211456");
+    test_ext_gcd("36893488147419103231", "18446744073709551615");
+    test_ext_gcd("354224848179261915075", "218922995834555169026");
+    test_gcd_algorithms(3000, 2900, 400);
+    test_gcd_algorithms(6000, 1200, 20);
+    test_gcd_algorithms(400, 400, 1);
+    size_t hgcd = GetThreshold(THRESHOLD_HGCD);
+    for (uint64_t seed = 1; seed <= 4; seed++) {
+        test_gcd_random(hgcd + 150 * seed, hgcd + 100 * seed, seed);
+    }
+    test_gcd_random(1600, 1550, 5);
+}
+
+void test_mod_inverse(char *s_a, char *s_mod, char *expected) {
+    BigNum a = CreateNum();
+    BigNum mod = CreateNum();
+    BigNum res = CreateNum();
+    SetFromStr(a, s_a);
+    SetFromStr(mod, s_mod);
+    if (expected == NULL) {
+        mu_check(ModInverse(a, mod, res) == ERROR);
+    } else {
+        BigNum expect = CreateNum();
+        SetFromStr(expect, expected);
+        mu_check(ModInverse(a, mod, res) == SUCCESS);
+        mu_check(Compare(res, expect) == 0);
+        FreeNum(expect);
+    }
+    FreeNum(a);
+    FreeNum(mod);
+    FreeNum(res);
+}
+
+MU_TEST(mod_inverse) {
+    test_mod_inverse("3", "7", "5");
+    test_mod_inverse("-3", "7", "2");
+    test_mod_inverse("10", "-17", "12");
+    test_mod_inverse("24", "7", "5");
+    test_mod_inverse("5", "1", "0");
+    test_mod_inverse("4", "8", NULL);
+    test_mod_inverse("0", "7", NULL);
+    test_mod_inverse("3", "0", NULL);
+    test_mod_inverse("2", "340282366920938463463374607431768211457", "170141183460469231731687303715884105729");
+    test_mod_inverse("340282366920938463463374607431768211456", "36893488147419103231", "4");
+    BigNum unset = CreateNum(), m = CreateNum(), res = CreateNum();
+    mu_check(SetFromStr(m, "7") == SUCCESS);
+    mu_check(ModInverse(unset, m, res) == ERROR);
+    mu_check(ModInverse(m, unset, res) == ERROR);
+    FreeNum(unset);
+    FreeNum(m);
+    FreeNum(res);
+}
+
+//products and divisions on a pool against the same on the calling thread alone
+void test_pool_algorithms(ThreadPool pool, size_t lhs_len, size_t rhs_len) {
+    char *s_lhs = make_digits(lhs_len, lhs_len + 5);
+    char *s_rhs = make_digits(rhs_len, rhs_len + 6);
+    BigNum lhs = CreateNum();
+    BigNum rhs = CreateNum();
+    BigNum expected[4], res[4];
+    for (int i = 0; i < 4; i++) {
+        expected[i] = CreateNum();
+        res[i] = CreateNum();
+    }
+    mu_check(SetFromStr(lhs, s_lhs) == SUCCESS);
+    mu_check(SetFromStr(rhs, s_rhs) == SUCCESS);
+    for (int pass = 0; pass < 2; pass++) {
+        BigNum *out = pass == 0 ? expected : res;
+        SetThreadPool(pass == 0 ? NULL : pool);
+        mu_check(Mult(lhs, rhs, out[0]) == SUCCESS);
+        mu_check(Sqr(lhs, out[1]) == SUCCESS);
+        mu_check(DivMod(lhs, rhs, out[2], out[3]) == SUCCESS);
+    }
+    SetThreadPool(NULL);
+    for (int i = 0; i < 4; i++) {
+        mu_check(Compare(res[i], expected[i]) == 0);
+        FreeNum(expected[i]);
+        FreeNum(res[i]);
+    }
+    FreeNum(lhs);
+    FreeNum(rhs);
+    free(s_lhs);
+    free(s_rhs);
+}
+
+MU_TEST(thread_pool) {
+    ThreadPool pool = CreateThreadPool(4);
+    mu_check(pool != NULL);
+    mu_check(SetPoolGrain(pool, 0) == ERROR);
+    mu_check(SetPoolGrain(pool, 8) == SUCCESS);
+    test_pool_algorithms(pool, 3000, 1500);
+    test_pool_algorithms(pool, 9000, 300);
+    test_pool_algorithms(pool, 20000, 19000);
+
+    size_t toom3 = GetThreshold(THRESHOLD_MUL_TOOM3), sqr_toom3 = GetThreshold(THRESHOLD_SQR_TOOM3);
+    size_t ntt = GetThreshold(THRESHOLD_MUL_NTT), sqr_ntt = GetThreshold(THRESHOLD_SQR_NTT);
+    mu_check(SetThreshold(THRESHOLD_MUL_TOOM3, 3) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_SQR_TOOM3, 3) == SUCCESS);
+    test_pool_algorithms(pool, 4000, 3500);
+    mu_check(SetThreshold(THRESHOLD_MUL_NTT, 20) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_SQR_NTT, 20) == SUCCESS);
+    test_pool_algorithms(pool, 90000, 85000);
+    mu_check(SetThreshold(THRESHOLD_MUL_TOOM3, toom3) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_SQR_TOOM3, sqr_toom3) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_NTT, ntt) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_SQR_NTT, sqr_ntt) == SUCCESS);
+
+    SetThreadPool(pool);
+    mu_check(GetThreadPool() == pool);
+    FreeThreadPool(pool);
+    mu_check(GetThreadPool() == NULL);
+}
+
+MU_TEST(inline_storage) {
+    BigNum a = CreateNum();
+    BigNum b = CreateNum();
+    mu_check(SetFromStr(a, "-99999999999999999999999999999999999999") == SUCCESS);
+    mu_check(SetFromStr(b, "18446744073709551615") == SUCCESS);
+    mu_check(a->limbs_ == a->inline_ && b->limbs_ == b->inline_);
+    mu_check(Add(b, b, b) == SUCCESS);
+    mu_check(Mult(b, b, b) == SUCCESS);
+    mu_check(b->limbs_ != b->inline_);
+    SwapNums(a, b);
+    mu_check(b->limbs_ == b->inline_);
+    char *str = ToStr(b);
+    mu_check(strcmp(str, "-99999999999999999999999999999999999999") == 0);
+    free(str);
+    str = ToStr(a);
+    mu_check(strcmp(str, "1361129467683753853705924477137396432900") == 0);
+    free(str);
+    FreeNum(a);
+    FreeNum(b);
+    test_operation("-18446744073709551615", "18446744073709551615", "-340282366920938463426481119284349108225", Mult);
+    test_operation("18446744073709551615", "1", "18446744073709551616", Add);
+    test_operation("-5", "-5", "0", Sub);
+    test_operation("5", "-7", "-2", Add);
+}
+
+static size_t hook_allocs = 0;
+
+static void *counting_malloc(size_t size) {
+    hook_allocs++;
+    return malloc(size);
+}
+
+MU_TEST(allocation_contexts) {
+    NumCtx contexts[2] = {CreateArenaCtx(256), CreatePoolCtx()};
+    BigNum outside = CreateNum();
+    for (int i = 0; i < 2; i++) {
+        NumCtx ctx = contexts[i];
+        mu_check(ctx != NULL);
+        BigNum a = CreateNumIn(ctx);
+        BigNum b = CreateNumIn(ctx);
+        mu_check(SetFromStr(a, "-340282366920938463463374607431768211457") == SUCCESS);
+        mu_check(SetFromStr(b, "18446744073709551617") == SUCCESS);
+        for (int j = 0; j < 40; j++) {
+            mu_check(MultInPlace(a, b) == SUCCESS);
+        }
+        SetThreadCtx(ctx);
+        mu_check(GCD(a, b, outside) == SUCCESS);
+        SetThreadCtx(NULL);
+        char *str = ToStr(outside);
+        mu_check(strcmp(str, "18446744073709551617") == 0);
+        free(str);
+        FreeNum(a);
+        FreeNum(b);
+        ReleaseCtx(ctx);
+        FreeCtx(ctx);
+    }
+    FreeNum(outside);
+
+    SetAllocFunctions(counting_malloc, NULL, NULL);
+    test_operation("123456789123456789123456789", "987654321987654321", "121932631356500531469135800347203169112635269", Mult);
+    SetAllocFunctions(NULL, NULL, NULL);
+    mu_check(hook_allocs > 0);
+}
+
+//carry chains are the hard part, so the operands mix random limbs with runs of zeroes and all ones
+static void fill_limbs(limb_t *a, size_t n, unsigned seed) {
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        unsigned kind = (seed >> 16) % 4;
+        a[i] = kind == 0 ? 0 : kind == 1 ? ~(limb_t) 0 : ((limb_t) seed << 40) ^ ((limb_t) seed * 0x9E3779B97F4A7C15ull);
+    }
+}
+
+MU_TEST(limb_kernels_agree) {
+    enum kernel_set best = limbs_best_kernels();
+    limb_t a[68], b[68], expected[68], r[68];
+    for (int set = KERNELS_GENERIC; set < KERNEL_SETS_COUNT; set++) {
+        if (limbs_use_kernels((enum kernel_set) set) == ERROR) continue;
+        for (size_t n = 0; n <= 67; n++) {
+            for (unsigned seed = 0; seed < 20; seed++) {
+                fill_limbs(a, n + 1, seed);
+                fill_limbs(b, n, seed + 1000);
+                limb_t carry = limbs_add_n_generic(expected, a, b, n);
+                mu_check(limbs_add_n(r, a, b, n) == carry && memcmp(r, expected, sizeof(limb_t) * n) == 0);
+                limb_t borrow = limbs_sub_n_generic(expected, a, b, n);
+                mu_check(limbs_sub_n(r, a, b, n) == borrow && memcmp(r, expected, sizeof(limb_t) * n) == 0);
+                memcpy(r, a, sizeof(limb_t) * n);
+                mu_check(limbs_sub_n(r, r, b, n) == borrow && memcmp(r, expected, sizeof(limb_t) * n) == 0);
+
+                limb_t m = n == 0 ? ~(limb_t) 0 : b[0] | 1;
+                limb_t high = limbs_mul_1_generic(expected, a, n, m, a[n]);
+                mu_check(limbs_mul_1(r, a, n, m, a[n]) == high && memcmp(r, expected, sizeof(limb_t) * n) == 0);
+                memcpy(expected, b, sizeof(limb_t) * n);
+                memcpy(r, b, sizeof(limb_t) * n);
+                high = limbs_addmul_1_generic(expected, a, n, m);
+                mu_check(limbs_addmul_1(r, a, n, m) == high && memcmp(r, expected, sizeof(limb_t) * n) == 0);
+                high = limbs_submul_1_generic(expected, a, n, m);
+                mu_check(limbs_submul_1(r, a, n, m) == high && memcmp(r, expected, sizeof(limb_t) * n) == 0);
+            }
+        }
+        test_operation("340282366920938463463374607431768211455", "1", "340282366920938463463374607431768211456", Add);
+        test_operation("340282366920938463463374607431768211456", "1", "340282366920938463463374607431768211455", Sub);
+        test_operation("340282366920938463463374607431768211455", "340282366920938463463374607431768211455",
+                       "115792089237316195423570985008687907852589419931798687112530834793049593217025", Mult);
+    }
+    mu_check(limbs_use_kernels(KERNEL_SETS_COUNT) == ERROR);
+    mu_check(limbs_use_kernels(best) == SUCCESS);
+}
+
+//every entry of a batch against the same operation on its own, with and without a pool
+MU_TEST(batches) {
+    enum {
+        N = 40
+    };
+    BigNum a[N], b[N], res[N], aliased[N], expected[N];
+    int8_t order[N];
+    ThreadPool pool = CreateThreadPool(3);
+    mu_check(SetPoolGrain(pool, 1) == SUCCESS);
+    for (size_t i = 0; i < N; i++) {
+        char *s_a = make_digits(1 + i * 37 % 400, (unsigned) i), *s_b = make_digits(1 + i * 53 % 300, (unsigned) i + 99);
+        a[i] = CreateNum();
+        b[i] = CreateNum();
+        res[i] = CreateNum();
+        aliased[i] = CreateNum();
+        expected[i] = CreateNum();
+        mu_check(SetFromStr(a[i], s_a) == SUCCESS);
+        mu_check(SetFromStr(b[i], i % 7 == 0 ? s_a : s_b) == SUCCESS);
+        a[i]->sign_ = i % 3 == 0 ? -1 : 1;
+        free(s_a);
+        free(s_b);
+    }
+    int8_t (*ops[3])(BigNum, BigNum, BigNum) = {Add, Sub, Mult};
+    int8_t (*batches[3])(const BigNum *, const BigNum *, BigNum *, size_t) = {AddBatch, SubBatch, MultBatch};
+    for (int pass = 0; pass < 2; pass++) {
+        SetThreadPool(pass == 0 ? NULL : pool);
+        for (int op = 0; op < 3; op++) {
+            mu_check(batches[op](a, b, res, N) == SUCCESS);
+            for (size_t i = 0; i < N; i++) {
+                mu_check(CopyNum(a[i], aliased[i]) == SUCCESS);
+            }
+            mu_check(batches[op](aliased, b, aliased, N) == SUCCESS);
+            for (size_t i = 0; i < N; i++) {
+                mu_check(ops[op](a[i], b[i], expected[i]) == SUCCESS);
+                mu_check(Compare(res[i], expected[i]) == 0);
+                mu_check(Compare(aliased[i], expected[i]) == 0);
+            }
+        }
+        mu_check(CompareBatch(a, b, order, N) == SUCCESS);
+        for (size_t i = 0; i < N; i++) {
+            mu_check(order[i] == Compare(a[i], b[i]));
+        }
+    }
+    SetThreadPool(NULL);
+    BigNum last = res[N - 1];
+    res[N - 1] = NULL;
+    mu_check(AddBatch(a, b, res, N) == ERROR);
+    res[N - 1] = last;
+    mu_check(CompareBatch(a, NULL, order, N) == ERROR);
+    for (size_t i = 0; i < N; i++) {
+        FreeNum(a[i]);
+        FreeNum(b[i]);
+        FreeNum(res[i]);
+        FreeNum(aliased[i]);
+        FreeNum(expected[i]);
+    }
+    FreeThreadPool(pool);
+}
+
+//struct-of-arrays batches against the constant-time routines on one operand at a time, with every kernel set
+MU_TEST(soa_batches) {
+    enum {
+        WIDTH = 3,
+        COUNT = 150
+    };
+    limb_t a[WIDTH * COUNT], b[WIDTH * COUNT], r[WIDTH * COUNT], carry[COUNT];
+    limb_t x[WIDTH], y[WIDTH], expected[WIDTH];
+    int8_t order[COUNT];
+    fill_limbs(a, WIDTH * COUNT, 1);
+    fill_limbs(b, WIDTH * COUNT, 2);
+    //the low limbs are equal everywhere, every fifth pair of operands is equal in full
+    memcpy(b, a, sizeof(limb_t) * COUNT);
+    for (size_t i = 0; i < COUNT; i += 5) {
+        for (size_t j = 0; j < WIDTH; j++) {
+            b[j * COUNT + i] = a[j * COUNT + i];
+        }
+    }
+    enum kernel_set best = limbs_best_kernels();
+    for (int set = KERNELS_GENERIC; set < KERNEL_SETS_COUNT; set++) {
+        if (limbs_use_kernels((enum kernel_set) set) == ERROR) continue;
+        for (int op = 0; op < 3; op++) {
+            if (op == 0) {
+                memcpy(r, a, sizeof(a));
+                AddSoA(r, carry, r, b, WIDTH, COUNT);
+            }
+            if (op == 1) SubSoA(r, carry, a, b, WIDTH, COUNT);
+            if (op == 2) CompareSoA(order, a, b, WIDTH, COUNT);
+            for (size_t i = 0; i < COUNT; i++) {
+                for (size_t j = 0; j < WIDTH; j++) {
+                    x[j] = a[j * COUNT + i];
+                    y[j] = b[j * COUNT + i];
+                }
+                if (op == 2) {
+                    mu_check(order[i] == CtCompare(x, y, WIDTH));
+                    continue;
+                }
+                mu_check((op == 0 ? CtAdd(expected, x, y, WIDTH) : CtSub(expected, x, y, WIDTH)) == carry[i]);
+                for (size_t j = 0; j < WIDTH; j++) {
+                    mu_check(r[j * COUNT + i] == expected[j]);
+                }
+            }
+        }
+    }
+    mu_check(limbs_use_kernels(best) == SUCCESS);
+}
+
+//num = 2^e, e < 64 * 72
+static void set_pow2(BigNum num, unsigned e) {
+    limb_t limbs[72] = {0};
+    limbs[e / LIMB_BITS] = (limb_t) 1 << e % LIMB_BITS;
+    mu_check(CtToNum(num, limbs, e / LIMB_BITS + 1) == SUCCESS);
+}
+
+//got and overflow have to be full reduced to n limbs and whether that changed it
+static void check_wrapped(BigNum full, const limb_t *got, size_t n, bool overflow) {
+    BigNum span = CreateNum();
+    BigNum res = CreateNum();
+    set_pow2(span, n * LIMB_BITS);
+    mu_check(overflow == (full->sign_ == -1 || Compare(full, span) != -1));
+    if (full->sign_ == -1) {
+        mu_check(Add(full, span, full) == SUCCESS);
+    } else {
+        mu_check(Mod(full, span, full) == SUCCESS);
+    }
+    mu_check(CtToNum(res, got, n) == SUCCESS && Compare(res, full) == 0);
+    FreeNum(span);
+    FreeNum(res);
+}
+
+#define TEST_FIXED_WIDTH(bits) \
+    static void test_fixed_##bits(unsigned seed) { \
+        enum { N = (bits) / LIMB_BITS }; \
+        BigNum x = CreateNum(), y = CreateNum(), full = CreateNum(), rem = CreateNum(), pow = CreateNum(); \
+        U##bits a, b, r, q, m; \
+        fill_limbs(a.limbs, N, seed); \
+        fill_limbs(b.limbs, N, seed + 1); \
+        /* short divisors and products that fit */ \
+        size_t keep = seed % 3 == 0 ? N / 2 : seed % 3 == 1 ? 1 : N; \
+        memset(b.limbs + keep, 0, sizeof(limb_t) * (N - keep)); \
+        mu_check(U##bits##ToNum(x, &a) == SUCCESS && U##bits##ToNum(y, &b) == SUCCESS); \
+        \
+        bool overflow = U##bits##Add(&r, &a, &b); \
+        mu_check(Add(x, y, full) == SUCCESS); \
+        check_wrapped(full, r.limbs, N, overflow); \
+        overflow = U##bits##Sub(&r, &a, &b); \
+        mu_check(Sub(x, y, full) == SUCCESS); \
+        check_wrapped(full, r.limbs, N, overflow); \
+        r = a; \
+        overflow = U##bits##Mult(&r, &r, &b); \
+        mu_check(Mult(x, y, full) == SUCCESS); \
+        check_wrapped(full, r.limbs, N, overflow); \
+        mu_check(U##bits##Compare(&a, &b) == Compare(x, y)); \
+        \
+        if (!U##bits##IsZero(&b)) { \
+            mu_check(U##bits##DivMod(&q, &m, &a, &b) == SUCCESS); \
+            mu_check(DivMod(x, y, full, rem) == SUCCESS); \
+            check_wrapped(full, q.limbs, N, false); \
+            check_wrapped(rem, m.limbs, N, false); \
+            r = a; \
+            mu_check(U##bits##DivMod(NULL, &r, &r, &b) == SUCCESS && U##bits##Compare(&r, &m) == 0); \
+            r = b; \
+            mu_check(U##bits##DivMod(&r, NULL, &a, &r) == SUCCESS && U##bits##Compare(&r, &q) == 0); \
+        } \
+        \
+        unsigned shift = seed * 37 % ((bits) + 10); \
+        set_pow2(pow, shift); \
+        overflow = U##bits##Shl(&r, &a, shift); \
+        mu_check(Mult(x, pow, full) == SUCCESS); \
+        check_wrapped(full, r.limbs, N, overflow); \
+        r = a; \
+        U##bits##Shr(&r, &r, shift); \
+        mu_check(Div(x, pow, full) == SUCCESS); \
+        check_wrapped(full, r.limbs, N, false); \
+        \
+        mu_check(U##bits##FromNum(&r, x) == SUCCESS && U##bits##Compare(&r, &a) == 0); \
+        set_pow2(pow, (bits)); \
+        mu_check(U##bits##FromNum(&r, pow) == ERROR); \
+        x->sign_ = -1; \
+        mu_check(U##bits##FromNum(&r, x) == ERROR || U##bits##IsZero(&a)); \
+        U##bits##SetU64(&b, 0); \
+        mu_check(U##bits##DivMod(&q, &m, &a, &b) == ERROR); \
+        FreeNum(x); \
+        FreeNum(y); \
+        FreeNum(full); \
+        FreeNum(rem); \
+        FreeNum(pow); \
+    }
+
+TEST_FIXED_WIDTH(256)
+
+TEST_FIXED_WIDTH(1024)
+
+MU_TEST(fixed_width) {
+    for (unsigned seed = 0; seed < 60; seed++) {
+        test_fixed_256(seed);
+        test_fixed_1024(seed);
+    }
+    U4096 big;
+    U4096SetU64(&big, 3);
+    mu_check(!U4096Shl(&big, &big, 4094) && U4096Shl(&big, &big, 1));
+    mu_check(big.limbs[63] == (limb_t) 1 << 63 && big.limbs[0] == 0);
+}
+
+//DivModBy against DivMod, with the outputs in place of the dividend too
+static void check_divisor(BigNum lhs, BigNum rhs) {
+    BigNum q = CreateNum(), r = CreateNum(), expected_q = CreateNum(), expected_r = CreateNum(), x = CreateNum();
+    Divisor divisor = CreateDivisor(rhs);
+    mu_check(divisor != NULL);
+    mu_check(DivMod(lhs, rhs, expected_q, expected_r) == SUCCESS);
+    mu_check(DivModBy(lhs, divisor, q, r) == SUCCESS);
+    mu_check(Compare(q, expected_q) == 0 && Compare(r, expected_r) == 0);
+    mu_check(Mult(q, rhs, x) == SUCCESS && Add(x, r, x) == SUCCESS && Compare(x, lhs) == 0);
+    mu_check(CopyNum(lhs, x) == SUCCESS && DivModBy(x, divisor, x, NULL) == SUCCESS && Compare(x, expected_q) == 0);
+    mu_check(CopyNum(lhs, x) == SUCCESS && DivModBy(x, divisor, NULL, x) == SUCCESS && Compare(x, expected_r) == 0);
+    FreeDivisor(divisor);
+    FreeNum(q);
+    FreeNum(r);
+    FreeNum(expected_q);
+    FreeNum(expected_r);
+    FreeNum(x);
+}
+
+MU_TEST(divisor) {
+    BigNum lhs = CreateNum(), rhs = CreateNum();
+    limb_t a[40], d[24];
+    size_t bz = GetThreshold(THRESHOLD_DIV_BZ);
+    for (unsigned seed = 0; seed < 300; seed++) {
+        size_t an = 1 + seed % 40, dn = 1 + seed * 7 % 24;
+        fill_limbs(a, an, seed);
+        fill_limbs(d, dn, seed + 1000);
+        //every other divisor shares its top limbs with the dividend, the case the quotient estimate saturates
+        if (seed % 2 == 0 && dn >= 2 && an >= dn) {
+            d[dn - 1] = a[an - 1];
+            d[dn - 2] = a[an - 2];
+        }
+        if (d[dn - 1] == 0) d[dn - 1] = seed;
+        if (dn == 1 && d[0] == 0) d[0] = 10;
+        mu_check(CtToNum(lhs, a, an) == SUCCESS && CtToNum(rhs, d, dn) == SUCCESS);
+        if (seed % 3 == 1) lhs->sign_ = lhs->size_ == 1 && a[0] == 0 ? 1 : -1;
+        if (seed % 5 == 2) rhs->sign_ = -1;
+        mu_check(SetThreshold(THRESHOLD_DIV_BZ, seed % 4 == 0 ? 4 : bz) == SUCCESS);
+        check_divisor(lhs, rhs);
+    }
+    mu_check(SetThreshold(THRESHOLD_DIV_BZ, bz) == SUCCESS);
+
+    char *digits = make_digits(2000, 11);
+    mu_check(SetFromStr(lhs, digits) == SUCCESS && SetFromStr(rhs, "10000000000000000000") == SUCCESS);
+    check_divisor(lhs, rhs);
+    mu_check(SetFromStr(rhs, "1") == SUCCESS);
+    check_divisor(lhs, rhs);
+    //the floor of a negative dividend carries out of an all-ones quotient, also through Burnikel-Ziegler
+    mu_check(SetFromStr(lhs, "-340282366920938463463374607431768211455") == SUCCESS);
+    mu_check(SetFromStr(rhs, "18446744073709551616") == SUCCESS);
+    check_divisor(lhs, rhs);
+    char *s_lhs = all_ones_negated(40), *s_rhs = power_of_limb_base(20);
+    mu_check(SetFromStr(lhs, s_lhs) == SUCCESS && SetFromStr(rhs, s_rhs) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_DIV_BZ, 4) == SUCCESS);
+    check_divisor(lhs, rhs);
+    mu_check(SetThreshold(THRESHOLD_DIV_BZ, bz) == SUCCESS);
+    free(s_lhs);
+    free(s_rhs);
+    BigNum unset = CreateNum();
+    mu_check(CreateDivisor(unset) == NULL);
+    FreeNum(unset);
+    mu_check(SetFromStr(rhs, "0") == SUCCESS);
+    mu_check(CreateDivisor(rhs) == NULL);
+    mu_check(DivModBy(lhs, NULL, rhs, NULL) == ERROR);
+    free(digits);
+    FreeNum(lhs);
+    FreeNum(rhs);
+}
+
+//a value of n pseudo-random limbs and the sign picked by the seed
+static void random_signed(BigNum num, size_t n, unsigned seed) {
+    limb_t a[64];
+    fill_limbs(a, n, seed);
+    CtToNum(num, a, n);
+    if (seed % 3 == 0 && !(num->size_ == 1 && num->limbs_[0] == 0)) num->sign_ = -1;
+}
+
+static void check_expr(Expr expr, ExprNode root, BigNum res, BigNum expected) {
+    mu_check(EvalExpr(expr, root, res) == SUCCESS);
+    mu_check(Compare(res, expected) == 0);
+}
+
+MU_TEST(expressions) {
+    BigNum a = CreateNum(), b = CreateNum(), c = CreateNum(), d = CreateNum(), e = CreateNum();
+    BigNum res = CreateNum(), t = CreateNum(), expected = CreateNum();
+    for (unsigned seed = 0; seed < 120; seed++) {
+        random_signed(a, 1 + seed % 50, seed);
+        random_signed(b, 1 + seed * 7 % 43, seed + 1);
+        random_signed(c, 1 + seed * 5 % 9, seed + 2);
+        random_signed(d, 1 + seed * 3 % 61, seed + 3);
+        random_signed(e, 1 + seed * 11 % 64, seed + 4);
+        if (seed % 10 == 5) CopyNum(a, c);
+        Expr expr = CreateExpr();
+        ExprNode na = ExprNum(expr, a), nb = ExprNum(expr, b), nc = ExprNum(expr, c);
+        ExprNode nd = ExprNum(expr, d), ne = ExprNum(expr, e);
+
+        //a * b + c * d - e
+        ExprNode sum = ExprSub(expr, ExprAdd(expr, ExprMult(expr, na, nb), ExprMult(expr, nc, nd)), ne);
+        Mult(a, b, expected);
+        Mult(c, d, t);
+        Add(expected, t, expected);
+        Sub(expected, e, expected);
+        check_expr(expr, sum, res, expected);
+
+        //x = a * b used three times, (x + c) * x - x
+        ExprNode x = ExprMult(expr, na, nb);
+        ExprNode shared = ExprSub(expr, ExprMult(expr, ExprAdd(expr, x, nc), x), x);
+        Mult(a, b, t);
+        Add(t, c, expected);
+        Mult(expected, t, expected);
+        Sub(expected, t, expected);
+        check_expr(expr, shared, res, expected);
+
+        //(a - b) - (c * d - (e + a))
+        ExprNode nested = ExprSub(expr, ExprSub(expr, na, nb),
+                                  ExprSub(expr, ExprMult(expr, nc, nd), ExprAdd(expr, ne, na)));
+        Sub(a, b, expected);
+        Mult(c, d, t);
+        Sub(expected, t, expected);
+        Add(expected, e, expected);
+        Add(expected, a, expected);
+        check_expr(expr, nested, res, expected);
+
+        //the result overwrites a number the expression reads
+        Mult(a, b, expected);
+        Mult(c, d, t);
+        Add(expected, t, expected);
+        Sub(expected, e, expected);
+        check_expr(expr, sum, a, expected);
+        FreeExpr(expr);
+    }
+
+    Expr expr = CreateExpr();
+    ExprNode na = ExprNum(expr, a);
+    mu_check(ExprAdd(expr, na, 7) == EXPR_INVALID);
+    mu_check(ExprMult(expr, ExprNum(expr, NULL), na) == EXPR_INVALID);
+    mu_check(EvalExpr(expr, EXPR_INVALID, res) == ERROR);
+    check_expr(expr, na, res, a);
+    BigNum empty = CreateNum();
+    mu_check(EvalExpr(expr, ExprAdd(expr, na, ExprNum(expr, empty)), res) == ERROR);
+    FreeNum(empty);
+    FreeExpr(expr);
+    FreeNum(a);
+    FreeNum(b);
+    FreeNum(c);
+    FreeNum(d);
+    FreeNum(e);
+    FreeNum(res);
+    FreeNum(t);
+    FreeNum(expected);
+}
+
+MU_TEST(fused_multiply_add) {
+    BigNum acc = CreateNum(), expected = CreateNum(), t = CreateNum(), a = CreateNum(), b = CreateNum();
+    mu_check(AddMul(acc, acc, acc) == SUCCESS && acc->size_ == 1 && acc->limbs_[0] == 0 && acc->sign_ == 1);
+    BigNum unset = CreateNum();
+    mu_check(SetFromStr(t, "-5") == SUCCESS && SubMul(t, unset, t) == SUCCESS && AddMul(t, t, unset) == SUCCESS);
+    mu_check(t->size_ == 1 && t->limbs_[0] == 5 && t->sign_ == -1);
+    mu_check(AddMulUi(unset, t, 0) == SUCCESS && unset->size_ == 1 && unset->limbs_[0] == 0);
+    FreeNum(unset);
+    //a dot product from a number that was never set
+    for (unsigned seed = 0; seed < 200; seed++) {
+        random_signed(a, 1 + seed * 7 % 60, seed);
+        random_signed(b, 1 + seed * 13 % 45, seed + 1);
+        if (seed == 0) mu_check(SetFromStr(expected, "0") == SUCCESS);
+        mu_check(Mult(a, b, t) == SUCCESS);
+        if (seed % 4 == 1) {
+            mu_check(SubMul(acc, a, b) == SUCCESS && Sub(expected, t, expected) == SUCCESS);
+        } else {
+            mu_check(AddMul(acc, a, b) == SUCCESS && Add(expected, t, expected) == SUCCESS);
+        }
+        mu_check(Compare(acc, expected) == 0);
+        //word operands, 0 and the largest one included
+        uint64_t w = seed % 5 == 0 ? 0 : seed % 5 == 1 ? UINT64_MAX : (uint64_t) seed * 0x9E3779B97F4A7C15ull;
+        mu_check(SetFromStr(t, "0") == SUCCESS && AddMulUi(t, a, w) == SUCCESS);
+        if (seed % 2 == 0) {
+            mu_check(AddMulUi(acc, a, w) == SUCCESS && Add(expected, t, expected) == SUCCESS);
+        } else {
+            mu_check(SubMulUi(acc, a, w) == SUCCESS && Sub(expected, t, expected) == SUCCESS);
+        }
+        mu_check(Compare(acc, expected) == 0);
+    }
+    mu_check(SetFromStr(t, "18446744073709551615") == SUCCESS && SubMulUi(t, t, 1) == SUCCESS);
+    mu_check(t->size_ == 1 && t->limbs_[0] == 0 && t->sign_ == 1);
+
+    //the accumulator as an operand: acc += acc * b, acc -= a * acc, acc += acc * acc
+    random_signed(a, 40, 7);
+    random_signed(b, 3, 9);
+    mu_check(CopyNum(a, acc) == SUCCESS);
+    mu_check(Mult(acc, b, t) == SUCCESS && Add(acc, t, expected) == SUCCESS);
+    mu_check(AddMul(acc, acc, b) == SUCCESS && Compare(acc, expected) == 0);
+    mu_check(Mult(b, acc, t) == SUCCESS && Sub(acc, t, expected) == SUCCESS);
+    mu_check(SubMul(acc, b, acc) == SUCCESS && Compare(acc, expected) == 0);
+    mu_check(Sqr(acc, t) == SUCCESS && Add(acc, t, expected) == SUCCESS);
+    mu_check(AddMul(acc, acc, acc) == SUCCESS && Compare(acc, expected) == 0);
+    mu_check(Mult(acc, acc, t) == SUCCESS && SubMul(acc, acc, acc) == SUCCESS);
+    mu_check(Sub(expected, t, expected) == SUCCESS && Compare(acc, expected) == 0);
+    FreeNum(acc);
+    FreeNum(expected);
+    FreeNum(t);
+    FreeNum(a);
+    FreeNum(b);
+}
+
+static void *count_in_thread(void *arg) {
+    BigNum x = CreateNum();
+    SetFromStr(x, (const char *) arg);
+    Mult(x, x, x);
+    FreeNum(x);
+    return NULL;
+}
+
+MU_TEST(statistics) {
+    struct NumStats stats;
+    ResetNumStats();
+    if (GetNumStats(&stats) == ERROR) {
+        //built without NUM_STATS, nothing is counted
+        mu_check(stats.calls[STAT_MULT] == 0 && stats.allocations == 0);
+        return;
+    }
+    mu_check(stats.calls[STAT_MULT] == 0 && stats.allocations == 0 && stats.tier_calls[STAT_MUL_BASECASE] == 0);
+
+    BigNum a = CreateNum(), b = CreateNum(), c = CreateNum();
+    char *digits = make_digits(2000, 3);
+    mu_check(SetFromStr(a, digits) == SUCCESS && SetFromStr(b, "123456789012345678901234567890") == SUCCESS);
+    mu_check(Mult(a, b, c) == SUCCESS);
+    mu_check(Add(a, c, c) == SUCCESS && Sub(c, b, c) == SUCCESS);
+    mu_check(DivMod(c, b, a, NULL) == SUCCESS);
+    size_t karatsuba = GetThreshold(THRESHOLD_MUL_KARATSUBA);
+    mu_check(SetThreshold(THRESHOLD_MUL_KARATSUBA, 2) == SUCCESS);
+    mu_check(Mult(a, a, c) == SUCCESS && Mult(a, b, c) == SUCCESS);
+    mu_check(SetThreshold(THRESHOLD_MUL_KARATSUBA, karatsuba) == SUCCESS);
+
+    mu_check(GetNumStats(&stats) == SUCCESS);
+    mu_check(stats.calls[STAT_CREATE] == 4); //DivMod creates the missing remainder
+    mu_check(stats.calls[STAT_SET_STR] == 2);
+    mu_check(stats.calls[STAT_MULT] == 2 && stats.calls[STAT_SQR] == 1);
+    mu_check(stats.calls[STAT_ADD] == 2 && stats.calls[STAT_DIVMOD] == 1);
+    //104 limbs fall into bucket 7, 65 to 128 limbs
+    mu_check(stats.sizes[STAT_MULT][7] == 2 && stats.sizes[STAT_DIVMOD][7] == 1);
+    mu_check(stats.tier_calls[STAT_MUL_BASECASE] >= 1 && stats.tier_calls[STAT_MUL_UNBALANCED] == 1);
+    mu_check(stats.tier_calls[STAT_SQR_KARATSUBA] + stats.tier_calls[STAT_SQR_TOOM3] >= 1);
+    mu_check(stats.tier_calls[STAT_DIV_BASECASE] + stats.tier_calls[STAT_DIV_BZ] == 1);
+    mu_check(stats.tier_ns[STAT_MUL_UNBALANCED] > 0);
+    mu_check(stats.allocations >= 3 && stats.frees >= 1 && stats.bytes_allocated >= 8 * 104);
+
+    //a finished thread keeps its counts
+    pthread_t thread;
+    mu_check(pthread_create(&thread, NULL, count_in_thread, digits) == 0);
+    mu_check(pthread_join(thread, NULL) == 0);
+    mu_check(GetNumStats(&stats) == SUCCESS);
+    mu_check(stats.calls[STAT_CREATE] == 5 && stats.calls[STAT_SQR] == 2 && stats.calls[STAT_SET_STR] == 3);
+
+    ResetNumStats();
+    mu_check(GetNumStats(&stats) == SUCCESS);
+    mu_check(stats.calls[STAT_SQR] == 0 && stats.tier_ns[STAT_MUL_UNBALANCED] == 0 && stats.frees == 0);
+    free(digits);
+    FreeNum(a);
+    FreeNum(b);
+    FreeNum(c);
 }
 
 MU_TEST_SUITE(test_suite) {
@@ -292,11 +1588,32 @@ MU_TEST_SUITE(test_suite) {
     MU_RUN_TEST(string_conversion_error_handling);
     MU_RUN_TEST(addition);
     MU_RUN_TEST(rep_arguments);
+    MU_RUN_TEST(in_place);
     MU_RUN_TEST(multiplication);
+    MU_RUN_TEST(mult_algorithms);
+    MU_RUN_TEST(base_conversion);
+    MU_RUN_TEST(buffers_and_streams);
+    MU_RUN_TEST(serialization);
+    MU_RUN_TEST(pow_mod);
+    MU_RUN_TEST(constant_time);
     MU_RUN_TEST(compare);
     MU_RUN_TEST(copy);
     MU_RUN_TEST(division);
+    MU_RUN_TEST(division_algorithms);
     MU_RUN_TEST(gcd);
+    MU_RUN_TEST(ext_gcd);
+    MU_RUN_TEST(mod_inverse);
+    MU_RUN_TEST(thread_pool);
+    MU_RUN_TEST(inline_storage);
+    MU_RUN_TEST(allocation_contexts);
+    MU_RUN_TEST(limb_kernels_agree);
+    MU_RUN_TEST(batches);
+    MU_RUN_TEST(soa_batches);
+    MU_RUN_TEST(fixed_width);
+    MU_RUN_TEST(divisor);
+    MU_RUN_TEST(expressions);
+    MU_RUN_TEST(fused_multiply_add);
+    MU_RUN_TEST(statistics);
 }
 
 int main() {
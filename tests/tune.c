@@ -0,0 +1,208 @@
+#include <number.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  Measures the crossover points of the host in the manner of GMP's tuneup. For every size of a range the operation
+  is timed with the threshold just above the size, which keeps the old algorithm, and at the size, which makes
+  the new one run for the top level with the old one below it. The threshold is the first size from which
+  the new algorithm wins STREAK times in a row. Thresholds are tuned in order and every one keeps its tuned value,
+  so Toom-3 is measured against the tuned Karatsuba and so on.
+  The result is a header for the TUNED_THRESHOLDS option of the library, see lib/CMakeLists.txt.
+
+  usage: tune [--min-time MS] [-o FILE]
+*/
+
+#define STREAK 3
+#define NEVER ((size_t) 1 << 40)
+
+static uint64_t state = 0x9E3779B97F4A7C15ull;
+
+static uint64_t random_limb() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static double seconds() {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+static double min_time = 0.01;
+static BigNum lhs, rhs, res, rem;
+static char *digits;
+
+//n random limbs, the top one not zero
+static void random_num(BigNum num, size_t n) {
+    limb_t *limbs = (limb_t *) malloc(sizeof(limb_t) * n);
+    for (size_t i = 0; i < n; i++) {
+        limbs[i] = random_limb();
+    }
+    limbs[n - 1] |= 1;
+    CtToNum(num, limbs, n);
+    free(limbs);
+}
+
+static void prepare_pair(size_t n) {
+    random_num(lhs, n);
+    random_num(rhs, n);
+}
+
+static void prepare_one(size_t n) {
+    random_num(lhs, n);
+}
+
+static void prepare_division(size_t n) {
+    random_num(lhs, 2 * n);
+    random_num(rhs, n);
+}
+
+static void prepare_digits(size_t n) {
+    random_num(lhs, n);
+    free(digits);
+    digits = ToStr(lhs);
+}
+
+static void run_mult() {
+    Mult(lhs, rhs, res);
+}
+
+static void run_sqr() {
+    Sqr(lhs, res);
+}
+
+static void run_divmod() {
+    DivMod(lhs, rhs, res, rem);
+}
+
+static void run_gcd() {
+    GCD(lhs, rhs, res);
+}
+
+static void run_to_str() {
+    free(ToStr(lhs));
+}
+
+static void run_set_str() {
+    SetFromStr(res, digits);
+}
+
+//a threshold, the macro of thresholds.h it sets and the operation it decides, on operands of n limbs
+struct param {
+    enum Threshold threshold;
+    const char *macro;
+    size_t min, max;
+    enum Threshold above; //tuned before and a lower bound, the threshold itself if there is none
+    void (*prepare)(size_t n);
+    void (*run)();
+};
+
+static const struct param params[] = {
+        {THRESHOLD_MUL_KARATSUBA, "MUL_KARATSUBA_THRESHOLD", 2, 300, THRESHOLD_MUL_KARATSUBA, prepare_pair, run_mult},
+        {THRESHOLD_MUL_TOOM3, "MUL_TOOM3_THRESHOLD", 3, 1500, THRESHOLD_MUL_KARATSUBA, prepare_pair, run_mult},
+        {THRESHOLD_MUL_NTT, "MUL_NTT_THRESHOLD", 100, 40000, THRESHOLD_MUL_TOOM3, prepare_pair, run_mult},
+        {THRESHOLD_SQR_KARATSUBA, "SQR_KARATSUBA_THRESHOLD", 2, 500, THRESHOLD_SQR_KARATSUBA, prepare_one, run_sqr},
+        {THRESHOLD_SQR_TOOM3, "SQR_TOOM3_THRESHOLD", 3, 2000, THRESHOLD_SQR_KARATSUBA, prepare_one, run_sqr},
+        {THRESHOLD_SQR_NTT, "SQR_NTT_THRESHOLD", 100, 60000, THRESHOLD_SQR_TOOM3, prepare_one, run_sqr},
+        {THRESHOLD_DIV_BZ, "DIV_BZ_THRESHOLD", 4, 600, THRESHOLD_DIV_BZ, prepare_division, run_divmod},
+        {THRESHOLD_HGCD, "HGCD_THRESHOLD", 3, 1500, THRESHOLD_HGCD, prepare_pair, run_gcd},
+        {THRESHOLD_GET_STR_DC, "GET_STR_DC_THRESHOLD", 2, 600, THRESHOLD_GET_STR_DC, prepare_one, run_to_str},
+        {THRESHOLD_SET_STR_DC, "SET_STR_DC_THRESHOLD", 2, 2000, THRESHOLD_SET_STR_DC, prepare_digits, run_set_str},
+};
+
+#define PARAMS_COUNT (sizeof(params) / sizeof(params[0]))
+
+//fastest time of one run among doubling batches
+static double measure(void (*run)()) {
+    double best = 0, total = 0;
+    size_t batch = 1, reps = 0;
+    while (total < min_time || reps == 0) {
+        double start = seconds();
+        for (size_t i = 0; i < batch; i++) {
+            run();
+        }
+        double elapsed = seconds() - start;
+        if (reps == 0 || elapsed / (double) batch < best) best = elapsed / (double) batch;
+        total += elapsed;
+        reps += batch;
+        if (elapsed < min_time / 10) batch *= 2;
+    }
+    return best;
+}
+
+static size_t tune(const struct param *param) {
+    size_t start = param->min;
+    if (param->above != param->threshold && GetThreshold(param->above) > start) start = GetThreshold(param->above);
+    size_t wins = 0, first_win = 0;
+    for (size_t n = start; n <= param->max; n += n / 16 > 0 ? n / 16 : 1) {
+        param->prepare(n);
+        SetThreshold(param->threshold, n + 1);
+        double old_time = measure(param->run);
+        SetThreshold(param->threshold, n);
+        double new_time = measure(param->run);
+        fprintf(stderr, "  %-24s %6zu limbs  %12.0f ns  %12.0f ns\n", param->macro, n, old_time * 1e9, new_time * 1e9);
+        if (new_time < old_time) {
+            if (wins++ == 0) first_win = n;
+            if (wins == STREAK) return first_win;
+        } else {
+            wins = 0;
+        }
+    }
+    return wins > 0 ? first_win : param->max;
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time = strtod(argv[++i], NULL) / 1000;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--min-time MS] [-o FILE]\n", argv[0]);
+            return 1;
+        }
+    }
+    lhs = CreateNum();
+    rhs = CreateNum();
+    res = CreateNum();
+    rem = CreateNum();
+
+    //the crossovers above the one being tuned stay out of the way until their turn
+    for (size_t i = 0; i < PARAMS_COUNT; i++) {
+        SetThreshold(params[i].threshold, NEVER);
+    }
+    size_t tuned[PARAMS_COUNT];
+    for (size_t i = 0; i < PARAMS_COUNT; i++) {
+        tuned[i] = tune(&params[i]);
+        SetThreshold(params[i].threshold, tuned[i]);
+        fprintf(stderr, "%s %zu\n", params[i].macro, tuned[i]);
+    }
+
+    FILE *out = out_path == NULL ? stdout : fopen(out_path, "w");
+    if (out == NULL) {
+        perror(out_path);
+        return 1;
+    }
+    fprintf(out, "//crossover points of the host in limbs, written by tune\n\n");
+    fprintf(out, "#ifndef ARBITARYPRECISIONARITHMETICS_TUNED_THRESHOLDS_H\n");
+    fprintf(out, "#define ARBITARYPRECISIONARITHMETICS_TUNED_THRESHOLDS_H\n\n");
+    for (size_t i = 0; i < PARAMS_COUNT; i++) {
+        fprintf(out, "#define %s %zu\n", params[i].macro, tuned[i]);
+    }
+    fprintf(out, "\n#endif //ARBITARYPRECISIONARITHMETICS_TUNED_THRESHOLDS_H\n");
+    if (out != stdout) fclose(out);
+
+    free(digits);
+    FreeNum(lhs);
+    FreeNum(rhs);
+    FreeNum(res);
+    FreeNum(rem);
+    return 0;
+}